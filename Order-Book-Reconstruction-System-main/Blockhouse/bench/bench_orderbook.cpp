@@ -0,0 +1,438 @@
+// Order book microbenchmarks and end-to-end replays of synthetic feeds.
+//
+// Results are written as one JSON document (stdout, or --output=<file>) so
+// runs can be archived and compared over time. Microbenchmark latencies are
+// per operation, timed in batches of BATCH operations so that clock reads
+// stay small next to the operation itself.
+#include "../include/book_engine.h"
+#include "../include/feed_generator.h"
+#include "../include/mbo_reader.h"
+#include "../include/mbp_sinks.h"
+#include "../include/metrics.h"
+#include "../include/orderbook.h"
+#include "../include/replay.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+static const char* const NULL_OUTPUT = "NUL";
+#else
+static const char* const NULL_OUTPUT = "/dev/null";
+#endif
+
+static constexpr size_t BATCH = 16;
+static constexpr size_t ORDERS_PER_LEVEL = 4;
+static constexpr int64_t MID = 100000;              // Ticks
+static constexpr int64_t TICK = 10000000;           // 0.01 in 1e-9 price units
+
+struct BenchOptions {
+    uint64_t micro_ops = 200000;
+    uint64_t replay_events = 2000000;
+    size_t repeat = 3;
+    std::string workdir = ".";
+};
+
+// Collects results as JSON objects
+class BenchReport {
+public:
+    void add(const std::string& object) {
+        std::cerr << object << std::endl;  // Progress
+        results.push_back(object);
+    }
+
+    std::string document() const {
+        std::string out = "{\"version\":1,\"results\":[\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            out += "  " + results[i] + (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out += "]}\n";
+        return out;
+    }
+
+private:
+    std::vector<std::string> results;
+};
+
+static std::string json_field(const char* key, const std::string& value) {
+    return std::string("\"") + key + "\":\"" + value + "\"";
+}
+
+static std::string json_field(const char* key, uint64_t value) {
+    return std::string("\"") + key + "\":" + std::to_string(value);
+}
+
+static std::string json_field(const char* key, double value) {
+    char text[64];
+    std::snprintf(text, sizeof(text), "\"%s\":%.3f", key, value);
+    return text;
+}
+
+// MBO rows built in memory and tokenized once; records point into lines,
+// which are never moved after parsing
+class RecordSet {
+public:
+    void add(char action, char side, int64_t ticks, uint64_t size, uint64_t order_id) {
+        char text[256];
+        int length = std::snprintf(text, sizeof(text),
+            "2025-07-17T08:00:00.000000000Z,2025-07-17T08:00:00.000000000Z,160,2,1108,%c,%c,%lld.%02lld0000000,%llu,0,%llu,130,165000,1,BENCH",
+            action, side, static_cast<long long>(ticks / 100), static_cast<long long>(ticks % 100),
+            static_cast<unsigned long long>(size), static_cast<unsigned long long>(order_id));
+        lines.emplace_back(text, static_cast<size_t>(length));
+    }
+
+    void parse() {
+        records.resize(lines.size());
+        for (size_t i = 0; i < lines.size(); i++) {
+            parse_mbo_record(lines[i], records[i]);
+        }
+    }
+
+    size_t size() const { return records.size(); }
+    const MboRecord& operator[](size_t i) const { return records[i]; }
+
+private:
+    std::vector<std::string> lines;
+    std::vector<MboRecord> records;
+};
+
+static int64_t level_price(char side, size_t rank) {
+    return side == 'B' ? MID - 1 - static_cast<int64_t>(rank) : MID + 1 + static_cast<int64_t>(rank);
+}
+
+// Time fn(i) for i in [0, count) in batches; each sample is one batch's
+// per-operation mean
+template <typename Fn>
+static HistogramSnapshot time_ops(size_t count, Fn&& fn) {
+    LatencyHistogram histogram;
+    for (size_t i = 0; i + BATCH <= count; i += BATCH) {
+        uint64_t start = metrics_now();
+        for (size_t j = i; j < i + BATCH; j++) {
+            fn(j);
+        }
+        histogram.record((metrics_now() - start) / BATCH);
+    }
+    HistogramSnapshot snapshot;
+    snapshot.add(histogram);
+    return snapshot;
+}
+
+static void report_micro(BenchReport& report, const char* name, const char* levels, size_t depth,
+                         uint64_t ops, const HistogramSnapshot& timing) {
+    report.add("{" + json_field("kind", std::string("micro")) + "," + json_field("name", std::string(name)) + "," +
+               json_field("levels", std::string(levels)) + "," + json_field("depth", static_cast<uint64_t>(depth)) + "," +
+               json_field("ops", ops) + "," +
+               json_field("mean_ns", timing.count ? timing.total / timing.count : 0) + "," +
+               json_field("p50_ns", timing.percentile(0.50)) + "," +
+               json_field("p99_ns", timing.percentile(0.99)) + "," +
+               json_field("max_ns", timing.max) + "}");
+}
+
+// add_order, cancel_order, depth lookup and snapshots on a book holding
+// depth levels per side
+template <typename Book>
+static void bench_book(BenchReport& report, const char* levels, size_t depth, const BenchOptions& options) {
+    std::mt19937_64 rng(depth);
+    std::geometric_distribution<int> near_touch(1.0 / (1.0 + static_cast<double>(depth) / 4.0));
+    auto pick_rank = [&] { return std::min<size_t>(static_cast<size_t>(near_touch(rng)), depth - 1); };
+    size_t ops = static_cast<size_t>(options.micro_ops) / BATCH * BATCH;
+
+    // Resting orders that define the book, then ops adds at existing levels
+    // (clustered near the touch) and their cancels in a shuffled order
+    RecordSet base;
+    uint64_t order_id = 1;
+    for (size_t rank = 0; rank < depth; rank++) {
+        for (size_t k = 0; k < ORDERS_PER_LEVEL; k++) {
+            base.add('A', 'B', level_price('B', rank), 100, order_id++);
+            base.add('A', 'A', level_price('A', rank), 100, order_id++);
+        }
+    }
+    base.parse();
+
+    RecordSet adds;
+    RecordSet cancels;
+    std::vector<size_t> cancel_order_ids(ops);
+    std::vector<std::pair<char, int64_t>> placed(ops);
+    for (size_t i = 0; i < ops; i++) {
+        char side = (rng() & 1) ? 'B' : 'A';
+        placed[i] = {side, level_price(side, pick_rank())};
+        adds.add('A', side, placed[i].second, 100, order_id + i);
+        cancel_order_ids[i] = i;
+    }
+    std::shuffle(cancel_order_ids.begin(), cancel_order_ids.end(), rng);
+    for (size_t i : cancel_order_ids) {
+        cancels.add('C', placed[i].first, placed[i].second, 100, order_id + i);
+    }
+    adds.parse();
+    cancels.parse();
+
+    Book book;
+    int row_depth = 0;
+    for (size_t i = 0; i < base.size(); i++) {
+        book.apply_mbo_action(base[i], row_depth);
+    }
+
+    report_micro(report, "add_order", levels, depth, ops, time_ops(ops, [&](size_t i) {
+        book.apply_mbo_action(adds[i], row_depth);
+    }));
+    report_micro(report, "cancel_order", levels, depth, ops, time_ops(ops, [&](size_t i) {
+        book.apply_mbo_action(cancels[i], row_depth);
+    }));
+
+    // Depth lookup: rank of random prices inside the book
+    std::vector<std::pair<char, Price>> probes(ops);
+    for (auto& probe : probes) {
+        char side = (rng() & 1) ? 'B' : 'A';
+        probe = {side, level_price(side, rng() % depth) * TICK};
+    }
+    volatile bool sink = false;
+    report_micro(report, "depth_lookup", levels, depth, ops, time_ops(ops, [&](size_t i) {
+        sink = book.affects_top_levels('A', probes[i].first, probes[i].second);
+    }));
+    (void)sink;
+
+    // Snapshot right after a top-10 change (the common case in a replay,
+    // timed per call), and the fully cached case
+    std::string snapshot;
+    snapshot.reserve(1024);
+    size_t snapshot_ops = std::min<size_t>(ops, 50000) / BATCH * BATCH;
+    RecordSet touches;
+    RecordSet untouches;
+    for (size_t i = 0; i < snapshot_ops; i++) {
+        char side = (rng() & 1) ? 'B' : 'A';
+        int64_t price = level_price(side, rng() % std::min<size_t>(depth, 10));
+        touches.add('A', side, price, 100, order_id + ops + i);
+        untouches.add('C', side, price, 100, order_id + ops + i);
+    }
+    touches.parse();
+    untouches.parse();
+
+    LatencyHistogram dirty;
+    for (size_t i = 0; i < snapshot_ops; i++) {
+        book.apply_mbo_action(touches[i], row_depth);
+        uint64_t start = metrics_now();
+        snapshot = book.get_mbp_10_snapshot(touches[i], i, row_depth);
+        dirty.record(metrics_now() - start);
+        book.apply_mbo_action(untouches[i], row_depth);
+    }
+    HistogramSnapshot dirty_timing;
+    dirty_timing.add(dirty);
+    report_micro(report, "get_mbp_10_snapshot", levels, depth, snapshot_ops, dirty_timing);
+    report_micro(report, "snapshot_cached", levels, depth, snapshot_ops, time_ops(snapshot_ops, [&](size_t i) {
+        snapshot.clear();
+        book.append_mbp_10_snapshot(touches[0], i, row_depth, snapshot);
+    }));
+}
+
+// Write a synthetic feed to path
+static bool write_feed(const std::string& path, const FeedProfile& profile) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    MboFeedGenerator generator(profile);
+    std::string block = std::string(MboFeedGenerator::HEADER) + "\n";
+    while (generator.next(block)) {
+        if (block.size() >= (size_t(1) << 20)) {
+            out.write(block.data(), static_cast<std::streamsize>(block.size()));
+            block.clear();
+        }
+    }
+    out.write(block.data(), static_cast<std::streamsize>(block.size()));
+    return out.good();
+}
+
+template <typename Book>
+static double replay_seconds(const std::string& feed, size_t threads) {
+    MboReader reader(feed);
+    CsvSink sink;
+    sink.open(NULL_OUTPUT, Book::DEPTH);
+    ReplayOptions options;
+    options.book.output_levels = Book::DEPTH;
+    uint64_t start = metrics_now();
+    if (threads > 1) {
+        reconstruct_parallel<Book>(reader, sink, options, threads);
+    } else {
+        reconstruct<Book>(reader, sink, options);
+    }
+    sink.close();
+    return static_cast<double>(metrics_now() - start) / 1e9;
+}
+
+template <typename Book>
+static void bench_replay(BenchReport& report, const char* scenario, const char* levels, const std::string& feed,
+                         const FeedProfile& profile, size_t threads, const BenchOptions& options) {
+    std::vector<double> runs;
+    for (size_t i = 0; i < options.repeat; i++) {
+        runs.push_back(replay_seconds<Book>(feed, threads));
+    }
+    std::sort(runs.begin(), runs.end());
+    double best = runs.front();
+    double median = runs[runs.size() / 2];
+    report.add("{" + json_field("kind", std::string("replay")) + "," + json_field("name", std::string(scenario)) + "," +
+               json_field("levels", std::string(levels)) + "," + json_field("threads", static_cast<uint64_t>(threads)) + "," +
+               json_field("events", profile.events) + "," +
+               json_field("instruments", static_cast<uint64_t>(profile.instruments)) + "," +
+               json_field("depth", static_cast<uint64_t>(profile.depth)) + "," +
+               json_field("best_s", best) + "," + json_field("median_s", median) + "," +
+               json_field("events_per_sec", static_cast<double>(profile.events) / best) + "}");
+}
+
+// Decode a feed into typed events, as a live feed handler would deliver them
+static std::vector<MboEvent> load_events(const std::string& feed) {
+    std::vector<MboEvent> events;
+    MboReader reader(feed);
+    MboEvent event;
+    for (; reader.available() > 0; reader.advance()) {
+        if (to_mbo_event(reader.peek(0), event)) events.push_back(event);
+    }
+    return events;
+}
+
+// Rows whose best bid is at or above the best ask; a generated feed must
+// have none, or every replay above times a book no exchange would show
+static uint64_t crossed_rows(const std::vector<MboEvent>& events) {
+    uint64_t crossed = 0;
+    auto engine = make_book_engine<OrderBook>([&crossed](const BookUpdate& update) {
+        const BookLevel& bid = update.bids[0];
+        const BookLevel& ask = update.asks[0];
+        if (bid.size > 0 && ask.size > 0 && bid.price >= ask.price) crossed++;
+    });
+    for (const MboEvent& event : events) {
+        engine.push(event);
+    }
+    engine.finish();
+    return crossed;
+}
+
+// The same replay through BookEngine: no parsing and no formatting; the
+// handler just counts the updates
+template <typename Book>
+static void bench_engine(BenchReport& report, const char* scenario, const char* levels,
+                         const std::vector<MboEvent>& events, const BenchOptions& options) {
+    std::vector<double> runs;
+    uint64_t updates = 0;
+    for (size_t i = 0; i < options.repeat; i++) {
+        updates = 0;
+        auto engine = make_book_engine<Book>([&updates](const BookUpdate&) { updates++; });
+        uint64_t start = metrics_now();
+        for (const MboEvent& event : events) {
+            engine.push(event);
+        }
+        engine.finish();
+        runs.push_back(static_cast<double>(metrics_now() - start) / 1e9);
+    }
+    std::sort(runs.begin(), runs.end());
+    double best = runs.front();
+    report.add("{" + json_field("kind", std::string("engine")) + "," + json_field("name", std::string(scenario)) + "," +
+               json_field("levels", std::string(levels)) + "," +
+               json_field("events", static_cast<uint64_t>(events.size())) + "," +
+               json_field("updates", updates) + "," +
+               json_field("best_s", best) + "," + json_field("median_s", runs[runs.size() / 2]) + "," +
+               json_field("events_per_sec", static_cast<double>(events.size()) / best) + "}");
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string output_filename;
+    bool run_micro = true;
+    bool run_replay = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--micro-ops=", 0) == 0) {
+            options.micro_ops = std::strtoull(arg.c_str() + 12, nullptr, 10);
+        } else if (arg.rfind("--events=", 0) == 0) {
+            options.replay_events = std::strtoull(arg.c_str() + 9, nullptr, 10);
+        } else if (arg.rfind("--repeat=", 0) == 0) {
+            options.repeat = std::max<size_t>(std::strtoul(arg.c_str() + 9, nullptr, 10), 1);
+        } else if (arg.rfind("--workdir=", 0) == 0 && arg.size() > 10) {
+            options.workdir = arg.substr(10);
+        } else if (arg.rfind("--output=", 0) == 0 && arg.size() > 9) {
+            output_filename = arg.substr(9);
+        } else if (arg == "--micro-only") {
+            run_replay = false;
+        } else if (arg == "--replay-only") {
+            run_micro = false;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--micro-ops=N] [--events=N] [--repeat=N] [--workdir=<dir>]"
+                      << " [--micro-only|--replay-only] [--output=<file>]" << std::endl;
+            return 1;
+        }
+    }
+
+    BenchReport report;
+
+    if (run_micro) {
+        for (size_t depth : {10, 100, 1000, 10000}) {
+            bench_book<OrderBook>(report, "ladder", depth, options);
+            bench_book<MapOrderBook>(report, "map", depth, options);
+        }
+    }
+
+    if (run_replay) {
+        struct Scenario {
+            const char* name;
+            FeedProfile profile;
+            size_t threads;
+        };
+        FeedProfile touch;           // One instrument, activity at the touch, heavy cancels
+        touch.events = options.replay_events;
+        FeedProfile resets = touch;  // Frequent book resets
+        resets.reset_every = 50000;
+        FeedProfile deep = touch;    // Wide book
+        deep.depth = 2000;
+        FeedProfile multi = touch;   // Many instruments, skewed activity
+        multi.instruments = 64;
+        const Scenario scenarios[] = {
+            {"touch", touch, 1},
+            {"resets", resets, 1},
+            {"deep", deep, 1},
+            {"multi", multi, 1},
+            {"multi", multi, 4},
+        };
+
+        for (const Scenario& scenario : scenarios) {
+            std::string feed = options.workdir + "/bench_feed_" + scenario.name + ".csv";
+            if (!write_feed(feed, scenario.profile)) {
+                std::cerr << "Error: Cannot write feed " << feed << std::endl;
+                return 1;
+            }
+            bench_replay<OrderBook>(report, scenario.name, "ladder", feed, scenario.profile, scenario.threads, options);
+            bench_replay<MapOrderBook>(report, scenario.name, "map", feed, scenario.profile, scenario.threads, options);
+            if (scenario.threads == 1 && scenario.profile.instruments == 1) {
+                // Same feed rendered as MBP-1 by the top-of-book specialization
+                bench_replay<BboOrderBook>(report, scenario.name, "ladder-mbp1", feed, scenario.profile, 1, options);
+            }
+            if (scenario.threads == 1) {
+                std::vector<MboEvent> events = load_events(feed);
+                uint64_t crossed = crossed_rows(events);
+                if (crossed > 0) {
+                    std::cerr << "Error: " << crossed << " crossed rows replaying feed " << scenario.name << std::endl;
+                    std::remove(feed.c_str());
+                    return 1;
+                }
+                bench_engine<OrderBook>(report, scenario.name, "ladder", events, options);
+            }
+            std::remove(feed.c_str());
+        }
+    }
+
+    std::string document = report.document();
+    if (output_filename.empty()) {
+        std::cout << document;
+    } else {
+        std::ofstream out(output_filename);
+        out << document;
+        if (!out.good()) {
+            std::cerr << "Error: Cannot write " << output_filename << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
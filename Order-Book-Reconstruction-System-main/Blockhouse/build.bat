@@ -13,6 +13,133 @@ if %errorlevel% neq 0 (
     exit /b 1
 )
 
+echo Compiling mbo_reader.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/mbo_reader.cpp -o obj/mbo_reader.o
+if %errorlevel% neq 0 (
+    echo Error compiling mbo_reader.cpp
+    exit /b 1
+)
+
+echo Compiling mbo_record.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/mbo_record.cpp -o obj/mbo_record.o
+if %errorlevel% neq 0 (
+    echo Error compiling mbo_record.cpp
+    exit /b 1
+)
+
+echo Compiling simd_scan.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/simd_scan.cpp -o obj/simd_scan.o
+if %errorlevel% neq 0 (
+    echo Error compiling simd_scan.cpp
+    exit /b 1
+)
+
+echo Compiling mapped_file.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/mapped_file.cpp -o obj/mapped_file.o
+if %errorlevel% neq 0 (
+    echo Error compiling mapped_file.cpp
+    exit /b 1
+)
+
+echo Compiling price.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/price.cpp -o obj/price.o
+if %errorlevel% neq 0 (
+    echo Error compiling price.cpp
+    exit /b 1
+)
+
+echo Compiling timestamp.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/timestamp.cpp -o obj/timestamp.o
+if %errorlevel% neq 0 (
+    echo Error compiling timestamp.cpp
+    exit /b 1
+)
+
+echo Compiling mbp_binary.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/mbp_binary.cpp -o obj/mbp_binary.o
+if %errorlevel% neq 0 (
+    echo Error compiling mbp_binary.cpp
+    exit /b 1
+)
+
+echo Compiling order_store.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/order_store.cpp -o obj/order_store.o
+if %errorlevel% neq 0 (
+    echo Error compiling order_store.cpp
+    exit /b 1
+)
+
+echo Compiling tfc_sequencer.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/tfc_sequencer.cpp -o obj/tfc_sequencer.o
+if %errorlevel% neq 0 (
+    echo Error compiling tfc_sequencer.cpp
+    exit /b 1
+)
+
+echo Compiling async_writer.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/async_writer.cpp -o obj/async_writer.o
+if %errorlevel% neq 0 (
+    echo Error compiling async_writer.cpp
+    exit /b 1
+)
+
+echo Compiling metrics.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/metrics.cpp -o obj/metrics.o
+if %errorlevel% neq 0 (
+    echo Error compiling metrics.cpp
+    exit /b 1
+)
+
+echo Compiling feed_generator.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/feed_generator.cpp -o obj/feed_generator.o
+if %errorlevel% neq 0 (
+    echo Error compiling feed_generator.cpp
+    exit /b 1
+)
+
+echo Compiling checkpoint.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/checkpoint.cpp -o obj/checkpoint.o
+if %errorlevel% neq 0 (
+    echo Error compiling checkpoint.cpp
+    exit /b 1
+)
+
+echo Compiling mbo_event.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/mbo_event.cpp -o obj/mbo_event.o
+if %errorlevel% neq 0 (
+    echo Error compiling mbo_event.cpp
+    exit /b 1
+)
+
+echo Compiling dbn.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/dbn.cpp -o obj/dbn.o
+if %errorlevel% neq 0 (
+    echo Error compiling dbn.cpp
+    exit /b 1
+)
+
+REM For zstd-compressed DBN input add -DHAVE_ZSTD here and -lzstd to the link lines
+echo Compiling dbn_reader.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/dbn_reader.cpp -o obj/dbn_reader.o
+if %errorlevel% neq 0 (
+    echo Error compiling dbn_reader.cpp
+    exit /b 1
+)
+
+echo Compiling shm_publisher.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/shm_publisher.cpp -o obj/shm_publisher.o
+if %errorlevel% neq 0 (
+    echo Error compiling shm_publisher.cpp
+    exit /b 1
+)
+
+echo Compiling replay_index.cpp...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/replay_index.cpp -o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error compiling replay_index.cpp
+    exit /b 1
+)
+
 echo Compiling main.cpp...
 g++ -std=c++17 -Wall -Wextra -O3 -march=native -Iinclude -c src/main.cpp -o obj/main.o
 if %errorlevel% neq 0 (
@@ -22,12 +149,61 @@ if %errorlevel% neq 0 (
 
 REM Link executable
 echo Linking executable...
-g++ -std=c++17 -Wall -Wextra -O3 -march=native -o reconstruction.exe obj/orderbook.o obj/main.o
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -o reconstruction.exe obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o obj/main.o
 if %errorlevel% neq 0 (
     echo Error linking executable
     exit /b 1
 )
 
+REM Archive the engine library (everything except main.o)
+echo Archiving libreconstruction.a...
+if exist libreconstruction.a del libreconstruction.a
+ar rcs libreconstruction.a obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error archiving libreconstruction.a
+    exit /b 1
+)
+
+REM Link tools (everything except main.o)
+echo Linking mbp_dump.exe...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -Iinclude -o mbp_dump.exe tools/mbp_dump.cpp obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error linking mbp_dump.exe
+    exit /b 1
+)
+
+echo Linking mbo_gen.exe...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -Iinclude -o mbo_gen.exe tools/mbo_gen.cpp obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error linking mbo_gen.exe
+    exit /b 1
+)
+
+echo Linking mbo_to_dbn.exe...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -Iinclude -o mbo_to_dbn.exe tools/mbo_to_dbn.cpp obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error linking mbo_to_dbn.exe
+    exit /b 1
+)
+
+echo Linking mbp_query.exe...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -Iinclude -o mbp_query.exe tools/mbp_query.cpp obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error linking mbp_query.exe
+    exit /b 1
+)
+
+REM examples\shm_consumer.cpp is not built here: shared book publishing
+REM (--publish) needs POSIX shared memory
+
+REM Link benchmarks
+echo Linking bench_orderbook.exe...
+g++ -std=c++17 -Wall -Wextra -O3 -march=native -pthread -Iinclude -o bench_orderbook.exe bench/bench_orderbook.cpp obj/orderbook.o obj/mbo_reader.o obj/mbo_record.o obj/simd_scan.o obj/mapped_file.o obj/price.o obj/timestamp.o obj/mbp_binary.o obj/order_store.o obj/tfc_sequencer.o obj/async_writer.o obj/metrics.o obj/feed_generator.o obj/checkpoint.o obj/mbo_event.o obj/dbn.o obj/dbn_reader.o obj/shm_publisher.o obj/replay_index.o
+if %errorlevel% neq 0 (
+    echo Error linking bench_orderbook.exe
+    exit /b 1
+)
+
 echo Build completed successfully!
 echo Executable: reconstruction.exe
 echo.
@@ -0,0 +1,105 @@
+// Follow the books a `reconstruction --publish=<file>` run keeps in shared
+// memory and print each change of a book's top level. Needs only
+// include/shm_book.h, no library:
+//
+//   g++ -std=c++17 -O2 -Iinclude -o shm_consumer examples/shm_consumer.cpp
+//   ./shm_consumer /dev/shm/books [--instrument=ID] [--publisher=ID]
+#include "shm_book.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void print_price(int64_t price) {
+    if (price == UNDEF_PRICE) {
+        std::printf("%12s", "-");
+    } else {
+        std::printf("%12.4f", static_cast<double>(price) / 1e9);
+    }
+}
+
+static void print_top(const MbpBinaryRecord& record) {
+    const MbpBinaryLevel& top = record.levels[0];
+    std::printf("%llu pub %u inst %u  %c  %8llu x", static_cast<unsigned long long>(record.ts_recv),
+                static_cast<unsigned>(record.publisher_id), static_cast<unsigned>(record.instrument_id),
+                record.action, static_cast<unsigned long long>(top.bid_sz));
+    print_price(top.bid_px);
+    std::printf("  |");
+    print_price(top.ask_px);
+    std::printf(" x %-8llu\n", static_cast<unsigned long long>(top.ask_sz));
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    long instrument = -1;
+    long publisher = -1;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--instrument=", 0) == 0) {
+            instrument = std::strtol(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--publisher=", 0) == 0) {
+            publisher = std::strtol(arg.c_str() + 12, nullptr, 10);
+        } else if (path.empty() && arg.rfind("--", 0) != 0) {
+            path = arg;
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok || path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <shm file> [--instrument=ID] [--publisher=ID]" << std::endl;
+        return 1;
+    }
+
+    // The writer may not have started yet
+    ShmBookReader reader;
+    while (!reader.open(path)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    size_t slot_count = reader.header().slot_count;
+    std::cerr << "Attached to " << path << ": " << slot_count << " slots, "
+              << reader.header().level_count << " levels per side" << std::endl;
+
+    // One known book is looked up once; otherwise every slot is polled
+    std::vector<uint64_t> seen(slot_count, 0);
+    std::vector<MbpBinaryLevel> tops(slot_count, MbpBinaryLevel{UNDEF_PRICE, UNDEF_PRICE, 0, 0, 0, 0});
+    size_t only = ShmBookReader::NOT_FOUND;
+    uint64_t last_count = 0;
+    uint64_t changes = 0;
+    MbpBinaryRecord record;
+    for (;;) {
+        // Read the state before the images, so the last pass sees the final ones
+        bool finished = reader.finished();
+        uint64_t count = reader.publish_count();
+        if (count != last_count) {
+            last_count = count;
+            if (instrument >= 0 && publisher >= 0 && only == ShmBookReader::NOT_FOUND) {
+                only = reader.find(static_cast<uint16_t>(publisher), static_cast<uint32_t>(instrument));
+            }
+            size_t first = (only != ShmBookReader::NOT_FOUND) ? only : 0;
+            size_t last = (only != ShmBookReader::NOT_FOUND) ? only + 1 : slot_count;
+            for (size_t index = first; index < last; index++) {
+                uint64_t sequence;
+                if (!reader.read(index, record, &sequence) || sequence == seen[index]) continue;
+                seen[index] = sequence;
+                if (instrument >= 0 && record.instrument_id != static_cast<uint32_t>(instrument)) continue;
+                if (publisher >= 0 && record.publisher_id != static_cast<uint16_t>(publisher)) continue;
+                if (std::memcmp(&tops[index], &record.levels[0], sizeof(MbpBinaryLevel)) == 0) continue;
+                tops[index] = record.levels[0];
+                print_top(record);
+                changes++;
+            }
+        }
+        if (finished) break;
+        std::this_thread::yield();
+    }
+
+    std::fflush(stdout);
+    std::cerr << "Writer finished: " << last_count << " images published, " << reader.header().books.load()
+              << " books, " << reader.header().dropped.load() << " dropped; " << changes << " printed" << std::endl;
+    return 0;
+}
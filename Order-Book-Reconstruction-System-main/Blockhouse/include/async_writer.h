@@ -0,0 +1,109 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+// Output file flushed by a background thread.
+//
+// Callers format straight into a large block (reserve() then commit()), and
+// each full block is handed to a writer thread that issues one write(2) for
+// it while the caller fills the other. The caller waits only when both
+// blocks are still queued behind the disk, so a stalling volume slows
+// processing only once a whole block of output is backed up.
+//
+// Every write but the last is exactly BLOCK_SIZE bytes from an aligned
+// buffer, which is what O_DIRECT needs: a row that crosses the block
+// boundary spills into the block's slack, and the spill moves to the front
+// of the next block.
+class AsyncFileWriter {
+public:
+    static constexpr size_t BLOCK_SIZE = size_t(4) << 20;    // Bytes per write(2)
+    static constexpr size_t MAX_RESERVE = size_t(64) << 10;  // Largest single reserve()
+    static constexpr size_t ALIGNMENT = 4096;                // Buffer and O_DIRECT alignment
+
+    AsyncFileWriter() = default;
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // Create or truncate filename. direct asks for O_DIRECT (Linux) to keep
+    // the output out of the page cache; it falls back to buffered writes
+    // where the file system refuses it.
+    //
+    // keep_bytes > 0 reopens an existing file instead, cut back to its first
+    // keep_bytes bytes, and appends from there; fails if the file is shorter.
+    bool open(const std::string& filename, bool direct = false, uint64_t keep_bytes = 0);
+
+    bool is_open() const { return fd >= 0; }
+    bool direct_io() const { return direct_mode; }
+
+    // Bytes write(2) has taken so far; stops growing at the first failed
+    // write. Safe to read from any thread
+    uint64_t bytes_written() const { return flushed.load(std::memory_order_relaxed); }
+
+    // Bytes appended so far, written or still buffered; the caller's thread
+    // only. This is the file offset the next append lands at.
+    uint64_t bytes_appended() const { return handed_off + fill; }
+
+    // Room for bytes (at most MAX_RESERVE) at the end of the output, valid
+    // until the next commit()
+    char* reserve(size_t bytes) {
+        (void)bytes;
+        return blocks[current] + fill;
+    }
+
+    // Append the first bytes of the last reservation
+    void commit(size_t bytes) {
+        fill += bytes;
+        if (fill >= BLOCK_SIZE) submit();
+    }
+
+    // Append arbitrary data
+    void write(const char* data, size_t bytes);
+
+    // Hand everything appended so far to the file and wait until it has been
+    // written; bytes_written() then covers all of it unless a write failed,
+    // in which case it stops at what reached the file. Returns false if any
+    // write failed. A flush that ends off an alignment boundary turns
+    // O_DIRECT off for the rest of the file.
+    bool flush();
+
+    // Flush everything, stop the writer thread and close the file. Returns
+    // false if any write failed.
+    bool close();
+
+private:
+    static constexpr size_t BLOCK_COUNT = 2;
+
+    bool keep_prefix(uint64_t keep_bytes);
+    void submit();
+    void run();
+    size_t write_block(const char* data, size_t bytes, bool last);   // Bytes written
+
+    int fd = -1;
+    bool direct_mode = false;
+
+    char* blocks[BLOCK_COUNT] = {};
+    size_t current = 0;   // Block the caller is filling
+    size_t fill = 0;      // Bytes in it
+    uint64_t handed_off = 0;  // Bytes queued for the writer thread, ever (plus any kept prefix)
+
+    // Shared with the writer thread
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t queued_bytes[BLOCK_COUNT] = {};  // Non-zero while a block waits to be written
+    bool final_block[BLOCK_COUNT] = {};     // Partial block (close or flush)
+    bool stopping = false;
+    bool failed = false;
+    std::atomic<uint64_t> flushed{0};
+    std::thread writer;
+};
+
+#endif // ASYNC_WRITER_H
@@ -0,0 +1,88 @@
+#ifndef BOOK_ENGINE_H
+#define BOOK_ENGINE_H
+
+#include "book_manager.h"
+#include "mbo_event.h"
+#include "orderbook.h"
+#include "tfc_sequencer.h"
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+// Embeddable reconstruction: typed MboEvents in, BookUpdates out, with no
+// text on either side. Part of libreconstruction.a.
+//
+// The handler is called as handler(const BookUpdate&) once per output row,
+// in the order the rows appear in the CSV output, with the same T->F->C
+// fusion, depth rules and changes-only filtering. Handler is a template
+// parameter, so a lambda or functor is inlined into the event loop: no
+// virtual call, no allocation and no formatting per event. The update and
+// the event it points to are only valid during the call.
+//
+//     BookEngine engine([&](const BookUpdate& update) { ... });
+//     engine.push(event);   // for each event, in feed order
+//     engine.finish();      // at end of stream
+//
+// Events are processed synchronously on the calling thread. A Trade is held
+// back until the rows after it show whether it opens a T->F->C sequence, so
+// its update (and those of the rows behind it) arrives during a later
+// push(); finish() releases whatever is still held.
+template <typename Handler, typename Book = OrderBook>
+class BookEngine {
+public:
+    explicit BookEngine(Handler handler, const BookOptions& options = BookOptions(),
+                        size_t tfc_window = TradeSequencer::DEFAULT_WINDOW)
+        : on_update(std::move(handler)), books(options), sequencer(tfc_window) {}
+
+    // Feed the next event in stream order
+    void push(const MboEvent& event) {
+        sequencer.push(event);
+        drain();
+    }
+
+    // End of stream (or a pause): deliver the updates still held back
+    void finish() {
+        sequencer.finish();
+        drain();
+    }
+
+    // An instrument's book, e.g. for L3 queue_position(); nullptr if unseen
+    const Book* find(uint16_t publisher_id, uint32_t instrument_id) const {
+        return books.find(publisher_id, instrument_id);
+    }
+
+    size_t book_count() const { return books.size(); }
+
+    Handler& handler() { return on_update; }
+
+private:
+    void drain() {
+        BasicSequencedEvent<MboEvent> event;
+        while (sequencer.next(event)) {
+            Book& orderbook = books.book_for(*event.record);
+            int depth = 0;
+            const MboEvent* shown = apply_sequenced_event(orderbook, event, fused_event, depth);
+            if (shown != nullptr) {
+                update.event = shown;
+                update.depth = static_cast<uint8_t>(depth);
+                orderbook.fill_book_update(update);
+                on_update(static_cast<const BookUpdate&>(update));
+            }
+        }
+    }
+
+    Handler on_update;
+    BookManager<Book> books;
+    BasicTradeSequencer<MboEvent> sequencer;
+    MboEvent fused_event;
+    BookUpdate update{};
+};
+
+// Engine over a chosen Book (e.g. MapOrderBook) with the handler type deduced
+template <typename Book = OrderBook, typename Handler>
+BookEngine<Handler, Book> make_book_engine(Handler handler, const BookOptions& options = BookOptions(),
+                                           size_t tfc_window = TradeSequencer::DEFAULT_WINDOW) {
+    return BookEngine<Handler, Book>(std::move(handler), options, tfc_window);
+}
+
+#endif // BOOK_ENGINE_H
@@ -0,0 +1,106 @@
+#ifndef BOOK_MANAGER_H
+#define BOOK_MANAGER_H
+
+#include "checkpoint.h"
+#include "orderbook.h"
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Routes MBO events to one book per (publisher_id, instrument_id).
+//
+// Books are created on an instrument's first event and live in one dense
+// array behind a single key -> slot index, so an idle instrument costs one
+// index entry plus an empty book (the level stores and order map only
+// allocate once orders arrive). Feeds tend to deliver runs of events for the
+// same instrument, so the last lookup is cached in front of the index.
+template <typename Book>
+class BookManager {
+public:
+    explicit BookManager(const BookOptions& options = BookOptions()) : options(options) {}
+
+    static uint64_t book_key(uint16_t publisher_id, uint32_t instrument_id) {
+        return (static_cast<uint64_t>(publisher_id) << 32) | instrument_id;
+    }
+
+    // Book owning record's instrument, created empty on first use (Record
+    // is an MboRecord or MboEvent)
+    template <typename Record>
+    Book& book_for(const Record& record) {
+        uint64_t key = book_key(record.publisher_id, record.instrument_id);
+        if (key == last_key) {
+            return *last_book;
+        }
+
+        auto it = slots.find(key);
+        if (it == slots.end()) {
+            it = slots.emplace(key, static_cast<uint32_t>(books.size())).first;
+            books.push_back(std::make_unique<Book>(options));
+        }
+        last_key = key;
+        last_book = books[it->second].get();
+        return *last_book;
+    }
+
+    // Existing book for an instrument, or nullptr if it has not traded
+    const Book* find(uint16_t publisher_id, uint32_t instrument_id) const {
+        auto it = slots.find(book_key(publisher_id, instrument_id));
+        return it == slots.end() ? nullptr : books[it->second].get();
+    }
+
+    size_t size() const { return books.size(); }
+
+    // Call visit(publisher_id, instrument_id, book) for every book, in no
+    // particular order
+    template <typename Visitor>
+    void visit_books(Visitor&& visit) const {
+        for (const auto& entry : slots) {
+            visit(static_cast<uint16_t>(entry.first >> 32), static_cast<uint32_t>(entry.first),
+                  static_cast<const Book&>(*books[entry.second]));
+        }
+    }
+
+    // Checkpointing: the book count, then each book's key and state
+    void save_state(CheckpointWriter& out) const {
+        out.put(static_cast<uint64_t>(books.size()));
+        for (const auto& entry : slots) {
+            out.put(entry.first);
+            books[entry.second]->save_state(out);
+        }
+    }
+
+    // Replace every book with the saved ones; false if the data is malformed
+    bool load_state(CheckpointReader& in) {
+        slots.clear();
+        books.clear();
+        last_key = UINT64_MAX;
+        last_book = nullptr;
+
+        uint64_t count = 0;
+        if (!in.get(count)) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t key = 0;
+            if (!in.get(key) || !slots.emplace(key, static_cast<uint32_t>(books.size())).second) {
+                return false;
+            }
+            books.push_back(std::make_unique<Book>(options));
+            if (!books.back()->load_state(in)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    BookOptions options;
+    std::unordered_map<uint64_t, uint32_t> slots;
+    std::vector<std::unique_ptr<Book>> books;
+    uint64_t last_key = UINT64_MAX;  // Not a valid key: publisher_id is 16 bits
+    Book* last_book = nullptr;
+};
+
+#endif // BOOK_MANAGER_H
@@ -0,0 +1,112 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <iosfwd>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Replay checkpoints: everything needed to continue a serial replay from the
+// middle of its input, namely the state of every book, where the next input
+// row starts, and how far the output had got.
+//
+// A file is one CheckpointHeader followed by payload_size bytes of book
+// state, all little-endian. The payload is checksummed, and files are
+// written to a temporary name and renamed into place, so a crash while
+// checkpointing leaves the previous checkpoint intact.
+
+static constexpr char CHECKPOINT_MAGIC[8] = {'M', 'B', 'P', 'C', 'K', 'P', 'T', '1'};
+static constexpr uint16_t CHECKPOINT_VERSION = 2;   // 1 did not record the input format
+
+struct CheckpointHeader {
+    char magic[8];
+    uint16_t version;
+    // Settings the saved state and output depend on; a resume must match them
+    uint8_t input_format;      // Reader::FORMAT_ID
+    uint8_t output_format;     // Sink::FORMAT_ID
+    uint8_t output_levels;
+    uint8_t changes_only;
+    uint8_t track_queues;
+    uint8_t reserved;
+    uint64_t tfc_window;
+    // Position in the run
+    uint64_t input_offset;     // Byte offset of the next input row
+    uint64_t row_index;        // Index of the next output row
+    uint64_t output_bytes;     // Output written before that row
+    uint64_t book_count;
+    uint64_t payload_size;
+    uint64_t payload_checksum; // FNV-1a
+};
+static_assert(sizeof(CheckpointHeader) == 72, "CheckpointHeader layout changed");
+
+// Appends plain values to a byte buffer
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(std::string& out) : bytes(out) {}
+
+    template <typename T>
+    void put(const T& value) {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+private:
+    std::string& bytes;
+};
+
+// Reads them back; every get() fails once the data runs out
+class CheckpointReader {
+public:
+    CheckpointReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+            cursor = end;
+            return false;
+        }
+        std::memcpy(&value, cursor, sizeof(value));
+        cursor += sizeof(value);
+        return true;
+    }
+
+    bool at_end() const { return cursor == end; }
+
+private:
+    const char* cursor;
+    const char* end;
+};
+
+struct Checkpoint {
+    CheckpointHeader header{};
+    std::string payload;   // Book state (see BookManager::save_state)
+
+    // Write to path via path + ".tmp", synced to disk before it is renamed
+    // into place; on any failure the temporary is removed, the previous
+    // checkpoint is left as it was, and false is returned
+    bool save(const std::string& path);
+
+    // Read and validate; false if the file is missing, truncated or corrupt
+    bool load(const std::string& path);
+
+    // The same encoding at the current position of a stream, for files that
+    // hold several checkpoints back to back (replay index keyframes).
+    // write() only reports the stream's state so far; bytes still buffered
+    // are checked by whoever closes the stream
+    bool write(std::ostream& out);
+    bool read(std::istream& in);
+
+    // Whether the run-independent settings equal those in settings
+    bool matches(const CheckpointHeader& settings) const {
+        return header.input_format == settings.input_format &&
+               header.output_format == settings.output_format &&
+               header.output_levels == settings.output_levels &&
+               header.changes_only == settings.changes_only &&
+               header.track_queues == settings.track_queues &&
+               header.tfc_window == settings.tfc_window;
+    }
+
+    static bool exists(const std::string& path);
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,121 @@
+#ifndef DBN_H
+#define DBN_H
+
+#include "mbo_event.h"
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Databento Binary Encoding (DBN), the native form of the MBO data the CSV
+// input is exported from. A file is a metadata block followed by
+// fixed-width little-endian records, each starting with a DbnRecordHeader
+// whose length is in 4-byte words. Versions 1 to 3 share the MBO record
+// layout and differ only in the metadata. Whole files are often
+// zstd-compressed (".dbn.zst").
+
+static constexpr char DBN_MAGIC[3] = {'D', 'B', 'N'};
+static constexpr uint8_t DBN_VERSION_MIN = 1;
+static constexpr uint8_t DBN_VERSION_MAX = 3;
+static constexpr uint8_t DBN_VERSION = 2;           // Written by encode_dbn_metadata
+static constexpr size_t DBN_PRELUDE_SIZE = 8;       // Magic, version, metadata length
+static constexpr uint32_t DBN_METADATA_MAX = 256u << 20;  // Longest metadata believed; real ones are far smaller
+static constexpr uint8_t DBN_RTYPE_MBO = 0xA0;      // The rtype column of the CSV (160)
+static constexpr uint16_t DBN_SCHEMA_MBO = 0;
+static constexpr uint16_t DBN_SCHEMA_MIXED = 0xFFFF;
+static constexpr uint8_t DBN_STYPE_INSTRUMENT_ID = 0;
+static constexpr uint8_t DBN_STYPE_RAW_SYMBOL = 1;
+static constexpr uint8_t DBN_STYPE_NONE = 0xFF;
+
+// First bytes of a zstd frame
+static constexpr uint8_t ZSTD_FRAME_MAGIC[4] = {0x28, 0xB5, 0x2F, 0xFD};
+
+struct DbnRecordHeader {
+    uint8_t length;         // Record size in 4-byte words
+    uint8_t rtype;
+    uint16_t publisher_id;
+    uint32_t instrument_id;
+    uint64_t ts_event;
+};
+static_assert(sizeof(DbnRecordHeader) == 16, "DbnRecordHeader layout changed");
+
+struct DbnMboMsg {
+    DbnRecordHeader hd;
+    uint64_t order_id;
+    int64_t price;          // 1e-9 ticks, INT64_MAX when absent (as Price)
+    uint32_t size;
+    uint8_t flags;
+    uint8_t channel_id;
+    char action;
+    char side;
+    uint64_t ts_recv;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+};
+static_assert(sizeof(DbnMboMsg) == 56, "DbnMboMsg layout changed");
+
+// The parts of the metadata block the replay uses. symbols is built from
+// the symbology mappings (whichever side of them is the instrument id);
+// when one id maps to several symbols over time, the last one wins.
+struct DbnMetadata {
+    uint8_t version = DBN_VERSION;
+    std::string dataset;
+    uint16_t schema = DBN_SCHEMA_MBO;
+    uint64_t start = 0;                  // Nanoseconds since the Unix epoch
+    uint64_t end = UINT64_MAX;
+    uint8_t stype_in = DBN_STYPE_RAW_SYMBOL;
+    uint8_t stype_out = DBN_STYPE_INSTRUMENT_ID;
+    bool ts_out = false;                 // Records carry a trailing send timestamp
+    SymbolMap symbols;
+};
+
+// Decode the metadata at the start of a (decompressed) DBN stream. Needs
+// at least DBN_PRELUDE_SIZE bytes to learn the full length, which is stored
+// in length either way. Returns false if data is not DBN, is a version
+// this reader does not know, claims more than DBN_METADATA_MAX bytes of
+// metadata, or is shorter than length.
+bool decode_dbn_metadata(const char* data, size_t size, DbnMetadata& metadata, size_t& length);
+
+// Append the metadata block for metadata (version DBN_VERSION, one
+// mapping interval per symbol covering start to end) to out
+void encode_dbn_metadata(const DbnMetadata& metadata, std::string& out);
+
+// Record <-> event; the fields are the same, only the order differs
+inline void to_mbo_event(const DbnMboMsg& msg, MboEvent& event) {
+    event.ts_recv = msg.ts_recv;
+    event.ts_event = msg.hd.ts_event;
+    event.order_id = msg.order_id;
+    event.price = msg.price;
+    event.size = msg.size;
+    event.instrument_id = msg.hd.instrument_id;
+    event.publisher_id = msg.hd.publisher_id;
+    event.flags = msg.flags;
+    event.channel_id = msg.channel_id;
+    event.action = msg.action;
+    event.side = msg.side;
+    event.ts_in_delta = msg.ts_in_delta;
+    event.sequence = msg.sequence;
+}
+
+inline void to_dbn_mbo(const MboEvent& event, DbnMboMsg& msg) {
+    msg.hd.length = sizeof(DbnMboMsg) / 4;
+    msg.hd.rtype = DBN_RTYPE_MBO;
+    msg.hd.publisher_id = event.publisher_id;
+    msg.hd.instrument_id = event.instrument_id;
+    msg.hd.ts_event = event.ts_event;
+    msg.order_id = event.order_id;
+    msg.price = event.price;
+    msg.size = event.size;
+    msg.flags = event.flags;
+    msg.channel_id = event.channel_id;
+    msg.action = event.action;
+    msg.side = event.side;
+    msg.ts_recv = event.ts_recv;
+    msg.ts_in_delta = event.ts_in_delta;
+    msg.sequence = event.sequence;
+}
+
+// Whether the file starts like a DBN stream, plain or zstd-compressed
+bool is_dbn_file(const std::string& filename);
+
+#endif // DBN_H
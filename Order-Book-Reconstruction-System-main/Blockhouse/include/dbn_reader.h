@@ -0,0 +1,95 @@
+#ifndef DBN_READER_H
+#define DBN_READER_H
+
+#include "dbn.h"
+#include "mapped_file.h"
+#include "mbo_event.h"
+#include <array>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Streaming reader for DBN MBO files, the binary counterpart of MboReader:
+// the same look-ahead window and position()/bytes_read() bookkeeping, but
+// each record is a fixed-width struct copied straight into an MboEvent, with
+// no text to split or parse. Records of other types are skipped.
+//
+// With use_mmap a plain file is mapped read-only and records are decoded in
+// place; otherwise it is read in large blocks. zstd-compressed files
+// (".dbn.zst") are decompressed as a stream into the same block buffer when
+// built with HAVE_ZSTD; without it they fail to open with an error saying
+// so. Offsets are always positions in the decompressed stream.
+class DbnReader {
+public:
+    using Record = MboEvent;
+    static constexpr uint8_t FORMAT_ID = 1;    // Recorded in checkpoints (MboReader is 0)
+    static constexpr size_t WINDOW = 5;
+    static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+    // start_offset > 0 resumes at that stream offset, which must be the start
+    // of a record (see position()); the metadata is read either way
+    explicit DbnReader(const std::string& filename, bool use_mmap = false, uint64_t start_offset = 0);
+    ~DbnReader();
+
+    DbnReader(const DbnReader&) = delete;
+    DbnReader& operator=(const DbnReader&) = delete;
+
+    // False when the file could not be opened or is not a DBN MBO stream;
+    // error() says why
+    bool is_open() const { return opened; }
+    const std::string& error() const { return failure; }
+
+    const DbnMetadata& metadata() const { return header; }
+    const SymbolMap& symbols() const { return header.symbols; }
+
+    // Number of buffered events starting at the current one (0 at end of input)
+    size_t available() const { return count; }
+
+    // Event k positions ahead of the current one; requires k < available()
+    const MboEvent& peek(size_t k) const { return ring[(head + k) % WINDOW].event; }
+
+    // Drop the current event and top the window back up
+    void advance();
+
+    // Stream bytes consumed so far, metadata and skipped records included
+    uint64_t bytes_read() const { return bytes; }
+
+    // Stream offset of the current event's record (of the end once drained)
+    uint64_t position() const { return count > 0 ? ring[head].offset : bytes; }
+
+private:
+    struct ZstdSource;
+    struct Slot {
+        MboEvent event;
+        uint64_t offset = 0;
+    };
+
+    bool open_source(const std::string& filename, bool use_mmap);
+    bool read_metadata();
+    bool skip_to(uint64_t offset);
+    bool ensure(size_t needed);
+    size_t read_source(char* out, size_t capacity);
+    void fill();
+
+    std::ifstream input;
+    MappedFile mapping;
+    std::unique_ptr<ZstdSource> zstd;
+    std::vector<char> buffer;
+    const char* cursor = nullptr;
+    const char* limit = nullptr;
+    bool exhausted = false;
+    uint64_t source_size = 0;   // Bytes in a plain file; 0 when unknown (zstd)
+
+    DbnMetadata header;
+    std::array<Slot, WINDOW> ring;
+    size_t head = 0;
+    size_t count = 0;
+    uint64_t bytes = 0;
+    bool opened = false;
+    std::string failure;
+};
+
+#endif // DBN_READER_H
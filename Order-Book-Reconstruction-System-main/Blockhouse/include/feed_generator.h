@@ -0,0 +1,114 @@
+#ifndef FEED_GENERATOR_H
+#define FEED_GENERATOR_H
+
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Shape of a synthetic MBO feed
+struct FeedProfile {
+    uint64_t events = 1000000;     // Rows to generate (a trade's T, F and C count as three)
+    uint32_t instruments = 1;      // Instruments, with activity skewed toward the first ones
+    size_t depth = 50;             // Price levels each side of the book spreads over
+    double cancel_ratio = 0.45;    // Share of decisions that cancel a resting order
+    double trade_ratio = 0.03;     // Share of decisions that trade (a T->F->C sequence)
+    double lone_trade_ratio = 0.0; // Share of decisions that print a trade with no book effect (T, side N)
+    double modify_ratio = 0.02;    // Share of decisions that modify a resting order
+    uint64_t reset_every = 0;      // Rows between book resets (R) of one instrument; 0: never
+    double events_per_second = 100000;  // Mean event rate across the feed (timestamps)
+    uint64_t seed = 1;
+};
+
+// Deterministic generator of MBO rows in the data/mbo.csv schema.
+//
+// Each instrument keeps its own resting orders by price level. New orders
+// are clustered near the touch (geometric distance inside the opposite best
+// price, so a quote never crosses the book), cancels and modifies pick a
+// random resting order, and trades take the oldest order at the best bid or
+// ask as T (aggressor side), F and C (the resting order's side and id). The
+// mid follows the touch as trades clear levels, with trades leaning back
+// toward the instrument's starting price. Lone trades print a T with side N
+// and touch nothing. Memory is bounded by the resting orders, so a feed can
+// run to any length.
+class MboFeedGenerator {
+public:
+    static const char* const HEADER;   // Column header line, without newline
+
+    explicit MboFeedGenerator(const FeedProfile& profile);
+
+    // Append the next row (newline included) to out; false once
+    // profile.events rows have been produced
+    bool next(std::string& out);
+
+    uint64_t rows_written() const { return rows; }
+
+private:
+    struct Resting {
+        uint64_t order_id;
+        int64_t price;     // Ticks
+        uint32_t size;
+        char side;
+    };
+    using Levels = std::map<int64_t, std::vector<uint64_t>>;   // Price -> order ids, oldest first
+    struct Instrument {
+        uint32_t instrument_id;
+        std::string symbol;
+        int64_t anchor;    // Ticks; the starting price trades lean back toward
+        int64_t mid;       // Ticks; midpoint of the touch
+        std::vector<Resting> orders;
+        std::unordered_map<uint64_t, size_t> index_of;   // order_id -> position in orders
+        Levels bids;
+        Levels asks;
+    };
+    struct PendingRow {
+        Instrument* instrument;
+        char action;
+        char side;
+        int64_t price;     // Ticks, or NO_PRICE
+        uint32_t size;
+        uint64_t order_id;
+        uint8_t flags;
+    };
+
+    static constexpr int64_t NO_PRICE = INT64_MIN;
+
+    void plan_next();
+    Instrument& pick_instrument();
+    void plan_add(Instrument& instrument);
+    void plan_cancel(Instrument& instrument);
+    void plan_modify(Instrument& instrument);
+    bool plan_trade(Instrument& instrument);
+    void plan_lone_trade(Instrument& instrument);
+    void plan_reset(Instrument& instrument);
+    void insert_order(Instrument& instrument, const Resting& order);
+    void remove_order(Instrument& instrument, size_t index);
+    void link_order(Instrument& instrument, const Resting& order);
+    void unlink_order(Instrument& instrument, const Resting& order);
+    void update_mid(Instrument& instrument);
+    int64_t quote_price(const Instrument& instrument, char side);
+    uint32_t order_size();
+    void render(const PendingRow& row, std::string& out);
+
+    FeedProfile profile;
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    std::geometric_distribution<int> touch_distance;
+    std::exponential_distribution<double> gap_ns;   // Nanoseconds between events
+    std::vector<Instrument> instruments;
+    std::vector<double> instrument_weights;   // Cumulative
+    size_t target_orders;                     // Typical resting orders per instrument
+
+    std::vector<PendingRow> pending;
+    size_t pending_head = 0;
+    uint64_t rows = 0;
+    uint64_t next_order_id = 1000000;
+    uint64_t sequence = 1;
+    uint64_t ts_event = 0;
+    uint64_t rows_since_reset = 0;
+};
+
+#endif // FEED_GENERATOR_H
@@ -0,0 +1,30 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file (POSIX only).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file; returns false if it cannot be opened or mapped
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const { return mapped; }
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+
+private:
+    const char* begin = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+};
+
+#endif // MAPPED_FILE_H
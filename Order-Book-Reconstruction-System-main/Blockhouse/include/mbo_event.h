@@ -0,0 +1,65 @@
+#ifndef MBO_EVENT_H
+#define MBO_EVENT_H
+
+#include "mbo_record.h"
+#include "price.h"
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+// Typed MBO event for embedding the engine (see book_engine.h): the columns
+// of an input row as plain values, laid out like Databento's MboMsg without
+// the record header. Nothing in it points into a text buffer, so it can be
+// copied freely and filled straight from a binary feed.
+struct MboEvent {
+    uint64_t ts_recv = 0;          // Nanoseconds since the Unix epoch
+    uint64_t ts_event = 0;
+    uint64_t order_id = 0;
+    Price price = UNDEF_PRICE;     // 1e-9 ticks; UNDEF_PRICE when absent
+    uint32_t size = 0;
+    uint32_t instrument_id = 0;
+    uint16_t publisher_id = 0;
+    uint8_t flags = 0;
+    uint8_t channel_id = 0;
+    char action = '\0';            // A, C, M, R, T, F
+    char side = '\0';              // B, A or N
+    int32_t ts_in_delta = 0;
+    uint32_t sequence = 0;
+};
+static_assert(sizeof(MboEvent) == 56, "MboEvent layout changed");
+
+// Instrument id to symbol, for typed events that don't carry one
+using SymbolMap = std::unordered_map<uint32_t, std::string>;
+
+// One price level as shown to callers; an empty level has price UNDEF_PRICE
+struct BookLevel {
+    Price price;
+    uint64_t size;
+    uint64_t count;
+};
+
+// The top of one book after an event that produces an output row: what a
+// CSV or binary row would hold, as values. bids[0] and asks[0] are the
+// best levels; only the first level_count of each side are filled.
+struct BookUpdate {
+    static constexpr size_t MAX_LEVELS = 10;
+
+    const MboEvent* event;     // The reported event (a fused T->F->C: the Trade, with the Cancel's side)
+    uint8_t depth;             // Level the event touched, as in the depth column
+    uint8_t level_count;       // BookOptions::output_levels
+    BookLevel bids[MAX_LEVELS];
+    BookLevel asks[MAX_LEVELS];
+};
+
+// Decode a tokenized CSV row; returns false when the row is not a valid event
+bool to_mbo_event(const MboRecord& record, MboEvent& event);
+
+// TradeSequencer's way of keeping a copy of an event; an MboEvent owns all
+// of its data, so storage is unused
+inline void copy_mbo_record(const MboEvent& event, std::string& storage, MboEvent& dst) {
+    (void)storage;
+    dst = event;
+}
+
+#endif // MBO_EVENT_H
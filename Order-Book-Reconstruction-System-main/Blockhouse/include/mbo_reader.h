@@ -0,0 +1,69 @@
+#ifndef MBO_READER_H
+#define MBO_READER_H
+
+#include "mbo_record.h"
+#include "mapped_file.h"
+#include <array>
+#include <fstream>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Streaming MBO reader with a bounded look-ahead window.
+// Only WINDOW rows are ever held in memory, so RSS stays flat regardless of
+// the input size and rows can be processed while the file is still being read.
+// Each row is tokenized exactly once, when it enters the window.
+//
+// With use_mmap the file is mapped read-only and rows are cut straight out
+// of the mapping with the SIMD newline scanner, skipping iostreams and the
+// per-line copy entirely.
+class MboReader {
+public:
+    using Record = MboRecord;
+    static constexpr uint8_t FORMAT_ID = 0;    // Recorded in checkpoints
+    
+    // Current row plus a few tokenized ahead; T->F->C detection keeps its
+    // own state (TradeSequencer) and only ever reads the current row
+    static constexpr size_t WINDOW = 5;
+
+    // start_offset > 0 resumes at that byte offset, which must be the start
+    // of a row (see position()); the header is only skipped from offset 0
+    explicit MboReader(const std::string& filename, bool use_mmap = false, uint64_t start_offset = 0);
+
+    bool is_open() const { return input.is_open() || mapping.is_open(); }
+
+    // Number of buffered rows starting at the current one (0 at end of input)
+    size_t available() const { return count; }
+
+    // Row k positions ahead of the current row; requires k < available()
+    const MboRecord& peek(size_t k) const { return ring[(head + k) % WINDOW].record; }
+
+    // Drop the current row and top the window back up from the file
+    void advance();
+
+    // Input consumed so far, line endings included
+    uint64_t bytes_read() const { return bytes; }
+
+    // Byte offset of the current row (of the end of input once drained)
+    uint64_t position() const { return count > 0 ? ring[head].offset : bytes; }
+
+private:
+    void fill();
+    bool next_line(std::string& storage, std::string_view& line);
+
+    struct Slot {
+        std::string line;
+        MboRecord record;
+        uint64_t offset = 0;   // Where the row starts in the file
+    };
+
+    std::ifstream input;
+    MappedFile mapping;
+    const char* cursor = nullptr;
+    std::array<Slot, WINDOW> ring;
+    size_t head = 0;
+    size_t count = 0;
+    uint64_t bytes = 0;
+};
+
+#endif // MBO_READER_H
@@ -0,0 +1,78 @@
+#ifndef MBO_RECORD_H
+#define MBO_RECORD_H
+
+#include "price.h"
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Column positions in the MBO CSV input
+enum MboField : uint8_t {
+    MBO_TS_RECV = 0,
+    MBO_TS_EVENT,
+    MBO_RTYPE,
+    MBO_PUBLISHER_ID,
+    MBO_INSTRUMENT_ID,
+    MBO_ACTION,
+    MBO_SIDE,
+    MBO_PRICE,
+    MBO_SIZE,
+    MBO_CHANNEL_ID,
+    MBO_ORDER_ID,
+    MBO_FLAGS,
+    MBO_TS_IN_DELTA,
+    MBO_SEQUENCE,
+    MBO_SYMBOL,
+    MBO_FIELD_COUNT
+};
+
+// One tokenized MBO row. Fields are stored as offsets into the caller's
+// buffer, so the record is only valid while that buffer is alive and
+// unchanged. Tokenizing never allocates.
+struct MboRecord {
+    static constexpr size_t MAX_FIELDS = 20;
+
+    const char* data = nullptr;
+    size_t field_count = 0;
+    uint16_t field_begin[MAX_FIELDS];
+    uint16_t field_end[MAX_FIELDS];
+
+    // Decoded once at parse time
+    char action = '\0';
+    char side = '\0';
+    Price price = UNDEF_PRICE;  // UNDEF_PRICE when the column is empty
+    uint64_t size = 0;
+    uint64_t order_id = 0;
+    uint16_t publisher_id = 0;
+    uint32_t instrument_id = 0;
+    bool valid = false;     // All MBO_FIELD_COUNT columns present and numerics decoded
+
+    std::string_view field(size_t index) const {
+        return std::string_view(data + field_begin[index], field_end[index] - field_begin[index]);
+    }
+};
+
+// Split a raw CSV row into trimmed fields and decode the columns the book
+// needs. Returns record.valid.
+bool parse_mbo_record(std::string_view line, MboRecord& record);
+
+// Copy record into dst with its text held in storage, for callers that keep
+// a record past the lifetime of the buffer it was parsed from. Reuses
+// storage's capacity.
+void copy_mbo_record(const MboRecord& record, std::string& storage, MboRecord& dst);
+
+// Decode a numeric column. An empty column leaves value as it was (the
+// column's default) and counts as success; false if the text is not a number
+// of type T.
+template <typename T>
+inline bool decode_number(std::string_view text, T& value) {
+    if (text.empty()) {
+        return true; // Empty numeric columns keep their default
+    }
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc();
+}
+
+#endif // MBO_RECORD_H
@@ -0,0 +1,109 @@
+#ifndef MBP_BINARY_H
+#define MBP_BINARY_H
+
+#include "async_writer.h"
+#include "mbo_event.h"
+#include "mbo_record.h"
+#include "price.h"
+#include <fstream>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Packed fixed-width MBP-10 output. A file is one MbpFileHeader followed by
+// back-to-back MbpBinaryRecords, all little-endian. Prices are int64 ticks
+// of 1e-9 (UNDEF_PRICE for an empty level), timestamps are nanoseconds since
+// the Unix epoch. Sizes are 64-bit like the book's aggregates, so a
+// record holds exactly what the CSV row prints. The row index of the CSV
+// output is the record's position in the file.
+
+static constexpr char MBP_BINARY_MAGIC[8] = {'M', 'B', 'P', '1', '0', 'B', 'I', 'N'};
+static constexpr uint16_t MBP_BINARY_VERSION = 2;   // 1 had 32-bit sizes
+static constexpr size_t MBP_BINARY_LEVELS = 10;
+
+struct MbpFileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t level_count;
+    uint32_t record_size;
+    int64_t price_scale;
+    uint64_t reserved;
+};
+static_assert(sizeof(MbpFileHeader) == 32, "MbpFileHeader layout changed");
+
+// Same field order as Databento's BidAskPair, with sizes widened to 64 bits
+// (a level's aggregate can pass 4G). Counts stay 32-bit: resting orders are
+// addressed by 32-bit pool indexes, so no level can hold more.
+struct MbpBinaryLevel {
+    int64_t bid_px;
+    int64_t ask_px;
+    uint64_t bid_sz;
+    uint64_t ask_sz;
+    uint32_t bid_ct;
+    uint32_t ask_ct;
+};
+static_assert(sizeof(MbpBinaryLevel) == 40, "MbpBinaryLevel layout changed");
+
+struct MbpBinaryRecord {
+    uint64_t ts_recv;
+    uint64_t ts_event;
+    int64_t price;
+    uint64_t order_id;
+    uint64_t size;
+    uint32_t instrument_id;
+    uint16_t publisher_id;
+    uint8_t rtype;
+    char action;
+    char side;
+    uint8_t flags;
+    uint8_t depth;
+    uint8_t reserved;
+    int32_t ts_in_delta;
+    uint32_t sequence;
+    uint32_t padding;   // Zero; keeps the levels 8-byte aligned
+    MbpBinaryLevel levels[MBP_BINARY_LEVELS];
+};
+static_assert(sizeof(MbpBinaryRecord) == 464, "MbpBinaryRecord layout changed");
+
+// Fill the event columns of out from an MBO row; levels are left to the book
+void fill_mbp_binary_event(const MboRecord& record, int depth, MbpBinaryRecord& out);
+void fill_mbp_binary_event(const MboEvent& event, int depth, MbpBinaryRecord& out);
+
+// Writer: header on open, then one record per write(), flushed by an
+// AsyncFileWriter thread. Records keep all MBP_BINARY_LEVELS slots; the
+// header's level_count says how many of them the book filled in (1 for
+// MBP-1 output), the rest are empty levels.
+class MbpBinaryWriter {
+public:
+    // keep_bytes > 0 appends to an existing file after that many bytes
+    // (header included) instead of starting a new one
+    bool open(const std::string& filename, size_t levels = MBP_BINARY_LEVELS, bool direct = false,
+              uint64_t keep_bytes = 0);
+    void write(const MbpBinaryRecord& record) {
+        std::memcpy(output.reserve(sizeof(record)), &record, sizeof(record));
+        output.commit(sizeof(record));
+    }
+    bool flush() { return output.flush(); }
+    // Returns false if the file could not be written completely
+    bool close() { return output.close(); }
+    uint64_t bytes_written() const { return output.bytes_written(); }
+    uint64_t bytes_appended() const { return output.bytes_appended(); }
+
+private:
+    AsyncFileWriter output;
+};
+
+// Sequential reader; validates the header on open
+class MbpBinaryReader {
+public:
+    bool open(const std::string& filename);
+    bool next(MbpBinaryRecord& record);
+    const MbpFileHeader& header() const { return file_header; }
+
+private:
+    std::ifstream input;
+    MbpFileHeader file_header{};
+};
+
+#endif // MBP_BINARY_H
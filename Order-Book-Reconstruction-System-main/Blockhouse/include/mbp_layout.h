@@ -0,0 +1,86 @@
+#ifndef MBP_LAYOUT_H
+#define MBP_LAYOUT_H
+
+#include "price.h"
+#include <string>
+#include <cstddef>
+
+// Column layout of the MBP CSV output for Depth levels per side: the row
+// index, 13 event columns, 6 columns per level (bid px/sz/ct, then ask
+// px/sz/ct), then the symbol and order id. That is 76 columns for MBP-10 and
+// 22 for MBP-1. Everything is constexpr, so a book templated on its depth
+// gets its layout (and buffer sizes) at compile time.
+
+enum MbpLevelField : size_t {
+    MBP_BID_PX = 0,
+    MBP_BID_SZ,
+    MBP_BID_CT,
+    MBP_ASK_PX,
+    MBP_ASK_SZ,
+    MBP_ASK_CT,
+    MBP_LEVEL_FIELDS
+};
+
+template <size_t Depth>
+struct MbpLayout {
+    static_assert(Depth >= 1 && Depth <= 99, "Level suffixes are two digits");
+
+    static constexpr size_t LEVELS = Depth;
+
+    // Event columns; column 0 is the unnamed row index
+    static constexpr size_t INDEX = 0;
+    static constexpr size_t TS_RECV = 1;
+    static constexpr size_t TS_EVENT = 2;
+    static constexpr size_t RTYPE = 3;
+    static constexpr size_t PUBLISHER_ID = 4;
+    static constexpr size_t INSTRUMENT_ID = 5;
+    static constexpr size_t ACTION = 6;
+    static constexpr size_t SIDE = 7;
+    static constexpr size_t DEPTH = 8;
+    static constexpr size_t PRICE = 9;
+    static constexpr size_t SIZE = 10;
+    static constexpr size_t FLAGS = 11;
+    static constexpr size_t TS_IN_DELTA = 12;
+    static constexpr size_t SEQUENCE = 13;
+
+    static constexpr size_t FIRST_LEVEL = 14;
+    static constexpr size_t level_column(size_t level, MbpLevelField field) {
+        return FIRST_LEVEL + level * MBP_LEVEL_FIELDS + field;
+    }
+
+    static constexpr size_t SYMBOL = level_column(Depth, MBP_BID_PX);
+    static constexpr size_t ORDER_ID = SYMBOL + 1;
+    static constexpr size_t COLUMN_COUNT = ORDER_ID + 1;
+
+    // Rendered "px,sz,ct" text of one side of one level, at most
+    static constexpr size_t LEVEL_TEXT_MAX = PRICE_TEXT_MAX + 48;
+    // Room to reserve for a row: event columns copied from the input are
+    // normally far shorter than this, the levels can never be longer
+    static constexpr size_t ROW_RESERVE = 256 + Depth * 2 * (LEVEL_TEXT_MAX + 1);
+};
+
+static_assert(MbpLayout<10>::COLUMN_COUNT == 76, "MBP-10 rows have 76 columns");
+static_assert(MbpLayout<10>::level_column(0, MBP_BID_PX) == 14, "bid_px_00 is column 14");
+static_assert(MbpLayout<1>::COLUMN_COUNT == 22, "MBP-1 rows have 22 columns");
+
+// Append "bid_px_00,bid_sz_00,...,ask_ct_NN," for levels levels per side
+inline void append_mbp_level_columns(std::string& header, size_t levels) {
+    static constexpr const char* LEVEL_NAMES[MBP_LEVEL_FIELDS] = {
+        "bid_px_", "bid_sz_", "bid_ct_", "ask_px_", "ask_sz_", "ask_ct_"};
+    for (size_t level = 0; level < levels; level++) {
+        char suffix[3] = {static_cast<char>('0' + level / 10), static_cast<char>('0' + level % 10), '\0'};
+        for (const char* column : LEVEL_NAMES) {
+            header.append(column).append(suffix).push_back(',');
+        }
+    }
+}
+
+// Header line (newline included) for rows with levels levels per side
+inline std::string mbp_csv_header(size_t levels) {
+    std::string header = ",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence,";
+    append_mbp_level_columns(header, levels);
+    header.append("symbol,order_id\n");
+    return header;
+}
+
+#endif // MBP_LAYOUT_H
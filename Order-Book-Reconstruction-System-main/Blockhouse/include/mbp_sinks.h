@@ -0,0 +1,172 @@
+#ifndef MBP_SINKS_H
+#define MBP_SINKS_H
+
+#include "async_writer.h"
+#include "mbo_event.h"
+#include "mbo_record.h"
+#include "mbp_binary.h"
+#include "mbp_layout.h"
+#include "shm_publisher.h"
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Output sinks for the replay loops in replay.h. Writing a row is split in
+// two: render() turns the book state after an event (a CSV MboRecord or a
+// typed MboEvent) into a Row and touches only that book and read-only sink
+// settings, so it can run on whichever thread owns the book; emit()
+// appends a rendered row under its final row index and runs on the single
+// thread that owns the file. Both sinks format into an AsyncFileWriter
+// block, so the disk itself is driven from a separate writer thread.
+
+// CSV rows, byte-compatible with data/mbp.csv
+class CsvSink {
+public:
+    using Row = std::string;  // The row minus its leading index
+    static constexpr uint8_t FORMAT_ID = 0;  // Recorded in checkpoints
+
+    // levels: columns per side, matching the books' BookOptions::output_levels;
+    // direct requests O_DIRECT output (see AsyncFileWriter); keep_bytes > 0
+    // resumes an existing file after that many bytes, header included
+    bool open(const std::string& filename, size_t levels = MBP_BINARY_LEVELS, bool direct = false,
+              uint64_t keep_bytes = 0) {
+        if (!output_file.open(filename, direct, keep_bytes)) {
+            return false;
+        }
+        if (keep_bytes > 0) {
+            return true;
+        }
+
+        // Write CSV header
+        std::string header = mbp_csv_header(levels);
+        output_file.write(header.data(), header.size());
+        return true;
+    }
+
+    // Symbols for typed events, which carry only an instrument id (DBN
+    // input); must outlive the sink and not change during a replay
+    void set_symbols(const SymbolMap* map) { symbols = map; }
+
+    template <typename Book>
+    void render(const Book& orderbook, const MboRecord& record, int depth, Row& row) const {
+        row.clear();
+        orderbook.append_mbp_10_fields(record, depth, row);
+    }
+
+    template <typename Book>
+    void render(const Book& orderbook, const MboEvent& event, int depth, Row& row) const {
+        row.clear();
+        orderbook.append_mbp_10_fields(event, symbol_for(event.instrument_id), depth, row);
+    }
+
+    // The rendered row is copied once into the output block, between its
+    // index and line ending. Rendering into a Row first is what lets the
+    // parallel path format rows on worker threads ahead of emit()
+    void emit(uint64_t row_index, const Row& row) {
+        static constexpr size_t INDEX_MAX = 20;
+        size_t bytes = INDEX_MAX + row.size() + 1;
+        if (bytes > AsyncFileWriter::MAX_RESERVE) {
+            emit_long(row_index, row);
+            return;
+        }
+        char* out = output_file.reserve(bytes);
+        char* end = std::to_chars(out, out + INDEX_MAX, row_index).ptr;
+        std::memcpy(end, row.data(), row.size());
+        end += row.size();
+        // Write with consistent line ending, no trailing spaces
+        *end++ = '\n';
+        output_file.commit(static_cast<size_t>(end - out));
+    }
+
+    bool flush() { return output_file.flush(); }
+    bool close() { return output_file.close(); }
+    uint64_t bytes_written() const { return output_file.bytes_written(); }
+    uint64_t bytes_appended() const { return output_file.bytes_appended(); }
+
+private:
+    std::string_view symbol_for(uint32_t instrument_id) const {
+        if (symbols == nullptr) return {};
+        auto it = symbols->find(instrument_id);
+        return it != symbols->end() ? std::string_view(it->second) : std::string_view();
+    }
+
+    // Rows too long for one reservation (pathological input fields)
+    void emit_long(uint64_t row_index, const Row& row) {
+        char index_text[24];
+        auto result = std::to_chars(index_text, index_text + sizeof(index_text), row_index);
+        output_file.write(index_text, static_cast<size_t>(result.ptr - index_text));
+        output_file.write(row.data(), row.size());
+        output_file.write("\n", 1);
+    }
+
+    AsyncFileWriter output_file;
+    const SymbolMap* symbols = nullptr;
+};
+
+// Packed fixed-width records (see mbp_binary.h)
+class BinarySink {
+public:
+    using Row = MbpBinaryRecord;
+    static constexpr uint8_t FORMAT_ID = 1;
+
+    bool open(const std::string& filename, size_t levels = MBP_BINARY_LEVELS, bool direct = false,
+              uint64_t keep_bytes = 0) {
+        return writer.open(filename, levels, direct, keep_bytes);
+    }
+
+    template <typename Book, typename Record>
+    void render(const Book& orderbook, const Record& record, int depth, Row& row) const {
+        orderbook.fill_mbp_10_record(record, depth, row);
+    }
+
+    void emit(uint64_t row_index, const Row& row) {
+        (void)row_index;  // Implied by the record's position in the file
+        writer.write(row);
+    }
+
+    bool flush() { return writer.flush(); }
+    bool close() { return writer.close(); }
+    uint64_t bytes_written() const { return writer.bytes_written(); }
+    uint64_t bytes_appended() const { return writer.bytes_appended(); }
+
+private:
+    MbpBinaryWriter writer;
+};
+
+// Latest image of each book in a shared region for live consumers (see
+// shm_book.h); nothing is written to disk. Rows are binary records, so a
+// consumer sees exactly what --format=binary would store.
+class ShmSink {
+public:
+    using Row = MbpBinaryRecord;
+    static constexpr uint8_t FORMAT_ID = 2;
+
+    bool open(const std::string& path, size_t levels = MBP_BINARY_LEVELS,
+              size_t slots = ShmBookPublisher::DEFAULT_SLOTS) {
+        return publisher.open(path, levels, slots);
+    }
+
+    template <typename Book, typename Record>
+    void render(const Book& orderbook, const Record& record, int depth, Row& row) const {
+        orderbook.fill_mbp_10_record(record, depth, row);
+    }
+
+    void emit(uint64_t row_index, const Row& row) {
+        (void)row_index;
+        publisher.publish(row);
+    }
+
+    bool flush() { return true; }   // Every image is visible once emitted
+    bool close() { return publisher.close(); }
+    uint64_t bytes_written() const { return publisher.published() * sizeof(Row); }
+    uint64_t bytes_appended() const { return bytes_written(); }
+    uint64_t published() const { return publisher.published(); }
+    uint64_t dropped() const { return publisher.dropped(); }
+
+private:
+    ShmBookPublisher publisher;
+};
+
+#endif // MBP_SINKS_H
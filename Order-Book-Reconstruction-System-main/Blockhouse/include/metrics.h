@@ -0,0 +1,197 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Replay instrumentation: per-stage, per-action latency histograms plus
+// throughput counters, reported as JSON.
+//
+// Each thread of a replay records into its own StageMetrics, so recording
+// never contends. Counters are relaxed atomics written by that one thread,
+// which lets the reporter thread take periodic snapshots while the replay
+// runs.
+
+// Monotonic clock in nanoseconds (clock_gettime(CLOCK_MONOTONIC) on Linux)
+inline uint64_t metrics_now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+enum MetricsStage : uint8_t {
+    STAGE_PARSE = 0,   // Reading and tokenizing a row
+    STAGE_BOOK,        // Applying an event (or fused T->F->C) to its book
+    STAGE_RENDER,      // Rendering the output row from the book
+    STAGE_WRITE,       // Handing the row to the output writer
+    STAGE_COUNT
+};
+
+// HDR-style log-linear histogram of nanosecond latencies: values below
+// 2 * SUB_BUCKETS are exact, larger ones land in one of SUB_BUCKETS buckets
+// per power of two (about 6% relative precision) up to the full 64-bit range.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS) * SUB_BUCKETS + 2 * SUB_BUCKETS;
+
+    // Single writer; safe to read concurrently
+    void record(uint64_t value) {
+        bump(buckets[bucket_of(value)], 1);
+        bump(total, value);
+        bump(samples, 1);
+        if (value > peak.load(std::memory_order_relaxed)) {
+            peak.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t bucket_of(uint64_t value) {
+        unsigned shift = 0;
+        if (value >= 2 * SUB_BUCKETS) {
+            shift = static_cast<unsigned>(63 - __builtin_clzll(value)) - SUB_BITS;
+        }
+        return (size_t(shift) << SUB_BITS) + static_cast<size_t>(value >> shift);
+    }
+
+    // Largest value that falls in bucket index
+    static uint64_t bucket_limit(size_t index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        unsigned shift = static_cast<unsigned>(index >> SUB_BITS) - 1;
+        uint64_t mantissa = (index & (SUB_BUCKETS - 1)) + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    friend struct HistogramSnapshot;
+
+    static void bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> peak{0};
+};
+
+// Point-in-time copy of one or more histograms, merged
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyHistogram::BUCKETS);
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max = 0;
+
+    void add(const LatencyHistogram& histogram);
+
+    // Upper bound of the bucket holding the q-quantile (0 < q <= 1), capped at max
+    uint64_t percentile(double q) const;
+};
+
+// Everything one replay thread records
+class StageMetrics {
+public:
+    // Rows are attributed to the action of the event they report
+    static constexpr char ACTIONS[] = {'A', 'C', 'M', 'T', 'F', 'R'};
+    static constexpr size_t ACTION_COUNT = sizeof(ACTIONS) + 1;  // Last slot: anything else
+
+    static size_t action_index(char action) {
+        for (size_t i = 0; i < sizeof(ACTIONS); i++) {
+            if (ACTIONS[i] == action) return i;
+        }
+        return ACTION_COUNT - 1;
+    }
+
+    void record(MetricsStage stage, char action, uint64_t nanoseconds) {
+        histograms[stage][action_index(action)].record(nanoseconds);
+    }
+
+    // One input event taken into the replay
+    void count_event() { events.store(events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    // Total input consumed by this thread's reader so far
+    void set_input_bytes(uint64_t bytes) { input_bytes.store(bytes, std::memory_order_relaxed); }
+
+private:
+    friend class ReplayMetrics;
+
+    LatencyHistogram histograms[STAGE_COUNT][ACTION_COUNT];
+    std::atomic<uint64_t> events{0};
+    std::atomic<uint64_t> input_bytes{0};
+};
+
+// Times consecutive stages of one event: each lap() records the time since
+// the previous lap (or construction). Does nothing without a StageMetrics.
+class StageClock {
+public:
+    explicit StageClock(StageMetrics* stats) : stats(stats), mark(stats ? metrics_now() : 0) {}
+
+    void lap(MetricsStage stage, char action) {
+        if (stats != nullptr) {
+            uint64_t now = metrics_now();
+            stats->record(stage, action, now - mark);
+            mark = now;
+        }
+    }
+
+private:
+    StageMetrics* stats;
+    uint64_t mark;
+};
+
+// Owns the StageMetrics of a run and writes reports.
+//
+// Reports are JSON Lines: with an interval, one snapshot per interval while
+// the replay runs, then the final snapshot (marked "final": true) when
+// stop() is called. Rows are the write samples.
+class ReplayMetrics {
+public:
+    ReplayMetrics() = default;
+    ~ReplayMetrics();
+
+    ReplayMetrics(const ReplayMetrics&) = delete;
+    ReplayMetrics& operator=(const ReplayMetrics&) = delete;
+
+    // Open the report file and start the clock (and the periodic reporter
+    // when interval_ms > 0)
+    bool start(const std::string& filename, uint64_t interval_ms = 0);
+
+    // Register a recording thread; call before that thread starts
+    StageMetrics& add_thread();
+
+    // Source of the output byte count, read from the reporter thread
+    void set_output_bytes(std::function<uint64_t()> counter) { output_bytes = std::move(counter); }
+
+    // Write the final report and close the file. Returns false if the
+    // report could not be written.
+    bool stop();
+
+    // Current totals as one line of JSON
+    std::string report(bool final) const;
+
+private:
+    void run(uint64_t interval_ms);
+
+    std::vector<std::unique_ptr<StageMetrics>> threads;
+    std::function<uint64_t()> output_bytes;
+    uint64_t start_ns = 0;
+
+    std::ofstream output;
+    std::mutex mutex;   // Guards threads and writes to output
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread reporter;
+};
+
+#endif // METRICS_H
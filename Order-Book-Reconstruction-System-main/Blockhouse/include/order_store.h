@@ -0,0 +1,139 @@
+#ifndef ORDER_STORE_H
+#define ORDER_STORE_H
+
+#include "price.h"
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Pool index meaning "no order" in queue links
+static constexpr uint32_t NO_ORDER = UINT32_MAX;
+
+struct Order {
+    Price price;
+    uint64_t size;
+    char side; // 'A' for Ask, 'B' for Bid
+    
+    // L3 mode only: links of the price level's time-priority queue, as pool
+    // indices so they stay valid when the pool grows
+    bool queued;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t rank;     // Arrival rank in the level's QueueRanks
+    uint64_t order_id;
+};
+
+// Resting orders by order_id.
+//
+// An open-addressing table (linear probing, backward-shift deletion, load
+// factor <= 1/2) maps order ids to records held in a slab pool. The pool
+// hands out fixed chunks of records and recycles freed ones, so add/cancel
+// does not touch the allocator once the book has warmed up, and a record
+// keeps its address until it is erased. Table slots carry the epoch they
+// were written in; clear() bumps the epoch and rewinds the pool, which
+// empties the store in O(1) while keeping all of its memory.
+class OrderStore {
+public:
+    // expected_orders pre-sizes the table and pool for that many resting
+    // orders; 0 defers all allocation to the first insert
+    explicit OrderStore(size_t expected_orders = 0);
+
+    void reserve(size_t expected_orders);
+
+    Order* find(uint64_t order_id) {
+        if (slots.empty()) return nullptr;
+        for (size_t i = home(order_id);; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.epoch != epoch) return nullptr;
+            if (slot.key == order_id) return &node(slot.node);
+        }
+    }
+
+    // Pool index of order_id's record, or NO_ORDER
+    uint32_t find_index(uint64_t order_id) const {
+        if (slots.empty()) return NO_ORDER;
+        for (size_t i = home(order_id);; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.epoch != epoch) return NO_ORDER;
+            if (slot.key == order_id) return slot.node;
+        }
+    }
+
+    // Pool index of order_id's record, inserted value-initialized if absent
+    uint32_t emplace(uint64_t order_id) {
+        if ((live + 1) * 2 > slots.size()) grow();
+        size_t i = home(order_id);
+        for (;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.epoch != epoch) break;
+            if (slot.key == order_id) return slot.node;
+        }
+        uint32_t index = allocate_node();
+        slots[i] = Slot{order_id, index, epoch};
+        live++;
+        node(index) = Order{};
+        return index;
+    }
+
+    Order& operator[](uint64_t order_id) { return node(emplace(order_id)); }
+
+    // Record by pool index; valid until that order is erased or the store cleared
+    Order& at(uint32_t index) { return node(index); }
+    const Order& at(uint32_t index) const { return node(index); }
+
+    bool erase(uint64_t order_id);
+
+    // Call visit(const Order&) for every resting order, in table order
+    template <typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (const Slot& slot : slots) {
+            if (slot.epoch == epoch) visit(node(slot.node));
+        }
+    }
+
+    size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+
+    void clear();
+
+private:
+    static constexpr unsigned CHUNK_BITS = 8;                 // 256 records per chunk
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t MIN_SLOTS = 16;
+
+    struct Slot {
+        uint64_t key;
+        uint32_t node;   // Pool index of the record
+        uint32_t epoch;  // Live only when equal to the store's epoch
+    };
+
+    size_t home(uint64_t order_id) const {
+        return static_cast<size_t>((order_id * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+
+    Order& node(uint32_t index) {
+        return chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+    const Order& node(uint32_t index) const {
+        return chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+
+    uint32_t allocate_node();
+    void grow();
+    void rehash(size_t slot_count);
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    unsigned shift = 64;
+    uint32_t epoch = 1;      // Slots start at epoch 0, i.e. empty
+    size_t live = 0;
+
+    // Pool: records [0, pool_used) have been handed out since the last
+    // clear(); free_nodes recycles the erased ones
+    std::vector<std::unique_ptr<Order[]>> chunks;
+    uint32_t pool_used = 0;
+    std::vector<uint32_t> free_nodes;
+};
+
+#endif // ORDER_STORE_H
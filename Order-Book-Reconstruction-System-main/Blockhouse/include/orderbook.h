@@ -1,54 +1,238 @@
 #ifndef ORDERBOOK_H
 #define ORDERBOOK_H
 
-#include <map>
-#include <unordered_map>
+#include "checkpoint.h"
+#include "mbo_event.h"
+#include "mbo_record.h"
+#include "mbp_binary.h"
+#include "mbp_layout.h"
+#include "order_store.h"
+#include "price.h"
+#include "price_levels.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
-struct Order {
-    double price;
-    uint64_t size;
-    char side; // 'A' for Ask, 'B' for Bid
+// Per-book settings, shared by every book a BookManager creates
+struct BookOptions {
+    size_t expected_orders = 0;  // Peak resting orders to pre-size for (0: grow on demand)
+    bool track_queues = false;   // L3: keep each level's orders in time priority
+    size_t output_levels = 10;   // Levels per side in each row, 1 to the book's Depth (clamped)
+    bool changes_only = false;   // Emit a row only when those levels changed
 };
 
-struct PriceLevel {
-    uint64_t total_size;
-    uint64_t order_count;
+// Where an order stands in its level's queue (L3 mode)
+struct QueuePosition {
+    size_t orders_ahead;     // Orders with time priority over it
+    uint64_t size_ahead;     // Their total remaining size
 };
 
-class OrderBook {
+// Where a price sits on one side of the book, looked up once per event
+struct LevelPosition {
+    size_t rank;    // Levels strictly better than the price
+    bool exists;    // A level at exactly this price is resting
+};
+
+// Cached "px,sz,ct" text for the (up to) Depth visible levels of one side. Only levels
+// flagged in dirty are re-rendered on the next snapshot; inserts and removals
+// shift the cached text along with the levels instead of reformatting it.
+// Depth is a compile-time bound, so the shifts and masks unroll.
+template <size_t Depth>
+struct SideImage {
+    static_assert(Depth >= 1 && Depth <= 16, "Level masks are 16 bits");
+    static constexpr size_t LEVELS = Depth;
+    static constexpr size_t TEXT_MAX = MbpLayout<Depth>::LEVEL_TEXT_MAX;
+    static constexpr uint16_t ALL_DIRTY = static_cast<uint16_t>((1u << LEVELS) - 1);
+
+    char text[LEVELS][TEXT_MAX];
+    uint8_t length[LEVELS] = {};
+    uint16_t dirty = ALL_DIRTY;
+    // Levels whose contents differ from the last reported row (an insert or
+    // removal changes every level from its rank down)
+    uint16_t changed = ALL_DIRTY;
+
+    void level_changed(size_t rank);
+    void level_inserted(size_t rank);
+    void level_removed(size_t rank);
+    void invalidate() { dirty = ALL_DIRTY; changed = ALL_DIRTY; }
+    static uint16_t top_mask(size_t levels) { return static_cast<uint16_t>((1u << levels) - 1); }
+};
+
+extern template struct SideImage<1>;
+extern template struct SideImage<MBP_BINARY_LEVELS>;
+
+// Levels selects the price-level store (LadderLevels or MapLevels, see
+// price_levels.h); both iterate best-first and produce identical output.
+//
+// Depth is the number of levels per side the book renders (1 for MBP-1, up
+// to MBP_BINARY_LEVELS for MBP-10). It sizes the cached images and bounds
+// every snapshot loop at compile time; BookOptions::output_levels can only
+// narrow it at run time.
+template <template <typename> class Levels, size_t Depth = MBP_BINARY_LEVELS>
+class BasicOrderBook {
+public:
+    static_assert(Depth >= 1 && Depth <= MBP_BINARY_LEVELS, "Depth must be 1 to MBP_BINARY_LEVELS");
+    static constexpr size_t DEPTH = Depth;
+    using Layout = MbpLayout<Depth>;
+    using Image = SideImage<Depth>;
+    
+    // The depth column reports an Add below the top MBP_BINARY_LEVELS as
+    // that first hidden slot, whatever the book's own Depth
+    static constexpr size_t REPORTED_DEPTH_MAX = MBP_BINARY_LEVELS;
+    
 private:
     // Bids: highest price first (descending order)
-    std::map<double, PriceLevel, std::greater<double>> bids;
+    Levels<BidSide> bids;
     // Asks: lowest price first (ascending order)  
-    std::map<double, PriceLevel> asks;
+    Levels<AskSide> asks;
     // Track orders by ID for cancellations/modifications
-    std::unordered_map<uint64_t, Order> orders;
+    OrderStore orders;
+    // Per-level order queues are maintained only in L3 mode
+    bool track_queues;
+    // Visible depth and the top-of-book change filter
+    size_t output_levels;
+    bool changes_only;
+    // L3 mode: rank trees of the levels with queues, by PriceLevel::queue_ranks;
+    // released trees keep their memory for the next level
+    std::vector<QueueRanks> rank_trees;
+    std::vector<uint32_t> free_rank_trees;
+    // Pre-rendered top-of-book text, refreshed lazily by snapshots
+    mutable Image bid_image;
+    mutable Image ask_image;
     
     // Helper methods
-    void add_order(uint64_t order_id, double price, uint64_t size, char side);
+    bool apply_action(char action, char side, uint64_t order_id, Price price, uint64_t size, int& depth);
+    bool apply_fused_cancel(char c_side, uint64_t order_id, Price price, uint64_t size, int& depth);
+    void add_order(uint64_t order_id, Price price, uint64_t size, char side, const LevelPosition& position);
     void cancel_order(uint64_t order_id, uint64_t size);
+    void modify_order(uint64_t order_id, Price price, uint64_t size, char side, const LevelPosition& position);
+    LevelPosition locate_level(char side, Price price) const;
+    bool affects_top_levels(char action, const LevelPosition& position) const;
+    
+    // Levels per side actually rendered; a constant for MBP-1 books
+    size_t visible_levels() const { return Depth == 1 ? 1 : output_levels; }
+    
+    // The px/sz/ct columns of each visible level, from the cached images
+    void append_level_fields(std::string& out) const;
+    
+    // Per-side level updates shared by add, cancel and modify
+    template <typename LevelStore>
+    PriceLevel& add_to_level(LevelStore& levels, Image& image, Price price, uint64_t size, const LevelPosition& position);
+    template <typename LevelStore>
+    bool take_from_level(LevelStore& levels, Image& image, Price price, uint64_t size,
+                         bool remove_order, uint32_t index, LevelPosition& vacated);
+    
+    // L3 queue maintenance; orders are referenced by pool index
+    PriceLevel* find_level(char side, Price price);
+    const PriceLevel* find_level(char side, Price price) const;
+    void enqueue_order(PriceLevel& level, uint32_t index);
+    void unlink_order(PriceLevel& level, uint32_t index);
+    void resize_queued_order(const PriceLevel& level, uint32_t index, uint64_t size);
+    void release_queue(PriceLevel& level);
+    void renumber_queue(const PriceLevel& level, QueueRanks& ranks);
     
 public:
-    OrderBook();
-    ~OrderBook();
+    explicit BasicOrderBook(const BookOptions& options = BookOptions());
+    ~BasicOrderBook();
+    
+    // Apply one event to the book. Returns false when the event produces no
+    // MBP-10 row; otherwise depth is the level the event touched.
+    bool apply_mbo_action(const MboRecord& record, int& depth);
+    
+    // Same for a typed event (see book_engine.h)
+    bool apply_mbo_action(const MboEvent& event, int& depth);
     
-    // Main processing method
+    // Main processing method (record already tokenized by parse_mbo_record)
+    void process_mbo_action(const MboRecord& record, std::string& output_line);
+    
+    // Convenience overload for callers holding a raw CSV row
     void process_mbo_action(const std::string& line, std::string& output_line);
     
     // Process T->F->C sequence as single action
-    void process_tfc_sequence(const std::string& t_line, const std::string& f_line, const std::string& c_line, std::string& output_line);
+    void process_tfc_sequence(const MboRecord& t_record, const MboRecord& f_record, const MboRecord& c_record, std::string& output_line);
+    
+    // Fused trade-cancel: apply the Cancel that resolves a T->F->C sequence.
+    // Returns false when it produces no row; the row itself is the Trade's,
+    // reported on the Cancel's side at the Cancel's depth.
+    bool apply_tfc_sequence(const MboRecord& t_record, const MboRecord& c_record, int& depth);
+    bool apply_tfc_sequence(const MboEvent& t_event, const MboEvent& c_event, int& depth);
+    
+    // Check if action affects the top Depth levels
+    bool affects_top_levels(char action, char side, Price price) const;
+    
+    // Whether the visible levels changed since the last reported row;
+    // report_top_levels() marks the current state as reported
+    bool top_levels_changed() const;
+    void report_top_levels();
     
-    // Check if action affects top 10 levels
-    bool affects_top10_levels(char action, char side, double price) const;
+    // Levels per side rendered into each row
+    size_t depth_levels() const { return visible_levels(); }
     
     // Generate MBP-10 snapshot
-    std::string get_mbp_10_snapshot(const std::vector<std::string>& mbo_fields, uint64_t row_index, int depth = 0) const;
+    std::string get_mbp_10_snapshot(const MboRecord& record, uint64_t row_index, int depth = 0) const;
+    
+    // Append the MBP-10 row to out without intermediate strings
+    void append_mbp_10_snapshot(const MboRecord& record, uint64_t row_index, int depth, std::string& out) const;
+    
+    // Same row without the leading row index (starts at the first comma)
+    void append_mbp_10_fields(const MboRecord& record, int depth, std::string& out) const;
+    
+    // Same row from a typed event (e.g. DBN input), which has no symbol column
+    void append_mbp_10_fields(const MboEvent& event, std::string_view symbol, int depth, std::string& out) const;
+    
+    // Fill the levels and level_count of a typed update; event and depth
+    // are the caller's
+    void fill_book_update(BookUpdate& out) const;
+    
+    // Fill a binary MBP-10 record (event columns plus the top 10 of each side)
+    void fill_mbp_10_record(const MboRecord& record, int depth, MbpBinaryRecord& out) const;
+    void fill_mbp_10_record(const MboEvent& event, int depth, MbpBinaryRecord& out) const;
+    
+    // L3 mode: the order's place in its level's queue, in O(log n) of the
+    // level's orders (see QueueRanks). Returns false if the order is not
+    // resting (or queues are not tracked).
+    bool queue_position(uint64_t order_id, QueuePosition& position) const;
+    
+    // L3 mode: call visit(const Order&) for each order resting at price, in
+    // time priority
+    template <typename Visitor>
+    void visit_queue(char side, Price price, Visitor&& visit) const {
+        uint32_t index = NO_ORDER;
+        if (side == 'B') {
+            auto it = bids.find(price);
+            if (it != bids.end()) index = it->second.queue_head;
+        } else if (side == 'A') {
+            auto it = asks.find(price);
+            if (it != asks.end()) index = it->second.queue_head;
+        }
+        for (; index != NO_ORDER; index = orders.at(index).next) {
+            visit(orders.at(index));
+        }
+    }
     
     // Clear the orderbook
     void clear();
+    
+    // Checkpointing: append the levels, resting orders (with L3 queue order)
+    // and the unreported-change state, or replace the book with them. Either
+    // level store reads what the other wrote.
+    void save_state(CheckpointWriter& out) const;
+    bool load_state(CheckpointReader& in);
 };
 
+// Contiguous ladder by default; the order-statistics tree store (MapLevels)
+// is kept for A/B runs
+using OrderBook = BasicOrderBook<LadderLevels>;
+using MapOrderBook = BasicOrderBook<MapLevels>;
+
+// Top-of-book only (--depth=1): one cached level per side, no level loops
+using BboOrderBook = BasicOrderBook<LadderLevels, 1>;
+using MapBboOrderBook = BasicOrderBook<MapLevels, 1>;
+
+extern template class BasicOrderBook<LadderLevels>;
+extern template class BasicOrderBook<MapLevels>;
+extern template class BasicOrderBook<LadderLevels, 1>;
+extern template class BasicOrderBook<MapLevels, 1>;
+
 #endif // ORDERBOOK_H
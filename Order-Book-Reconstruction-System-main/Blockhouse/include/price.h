@@ -0,0 +1,32 @@
+#ifndef PRICE_H
+#define PRICE_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-point price in integer ticks of 1e-9, the same encoding Databento
+// uses on the wire. Equality and ordering are exact.
+using Price = int64_t;
+
+static constexpr Price PRICE_SCALE = 1000000000;
+static constexpr int PRICE_DECIMALS = 9;
+
+// Sentinel for a missing price (Databento's UNDEF_PRICE)
+static constexpr Price UNDEF_PRICE = INT64_MAX;
+
+// Longest output of format_price: sign, 10 integer digits, '.', 9 decimals
+static constexpr size_t PRICE_TEXT_MAX = 24;
+
+// Parse a decimal string such as "5.510000000" into ticks. Digits beyond the
+// ninth decimal are truncated. Returns false on malformed input or overflow.
+bool parse_price(std::string_view text, Price& price);
+
+// Write the shortest exact decimal for price (no trailing zeros, no trailing
+// '.') into out, which must hold PRICE_TEXT_MAX bytes. Returns the length.
+size_t format_price(Price price, char* out);
+
+std::string price_to_string(Price price);
+
+#endif // PRICE_H
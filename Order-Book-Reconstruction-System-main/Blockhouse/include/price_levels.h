@@ -0,0 +1,192 @@
+#ifndef PRICE_LEVELS_H
+#define PRICE_LEVELS_H
+
+#include "order_store.h"
+#include "price.h"
+// MapLevels is built on libstdc++'s policy-based tree (ext/pb_ds), so the
+// book needs GCC's standard library (or clang with libstdc++); libc++ and
+// MSVC do not ship it
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+// Index meaning "no rank tree" in PriceLevel::queue_ranks
+static constexpr uint32_t NO_QUEUE_RANKS = UINT32_MAX;
+
+struct PriceLevel {
+    uint64_t total_size;
+    uint32_t order_count;   // Orders are addressed by 32-bit pool indexes
+    // L3 mode only: oldest and newest order of the time-priority queue, and
+    // the book's QueueRanks for it
+    uint32_t queue_head = NO_ORDER;
+    uint32_t queue_tail = NO_ORDER;
+    uint32_t queue_ranks = NO_QUEUE_RANKS;
+};
+
+// L3 mode only: a Fenwick tree over one level's arrival ranks, holding the
+// remaining size and count of the order that arrived with each rank. The
+// orders and size ahead of an order are then one O(log n) prefix sum.
+// Ranks only grow; when they run out the book renumbers the queue from 0
+// and rebuilds the tree, which is O(1) amortized per arrival.
+struct QueueRanks {
+    struct Node {
+        uint64_t size;
+        uint64_t count;
+    };
+    std::vector<Node> nodes;   // 1-based Fenwick layout, nodes[0] unused
+    uint32_t next_rank = 0;
+
+    uint32_t capacity() const { return nodes.empty() ? 0 : static_cast<uint32_t>(nodes.size() - 1); }
+
+    // Empty tree for ranks 0 to capacity - 1; keeps the memory
+    void reset(uint32_t capacity) {
+        nodes.assign(static_cast<size_t>(capacity) + 1, Node{0, 0});
+        next_rank = 0;
+    }
+
+    // Turn per-rank values stored at nodes[rank + 1] into the tree, in O(n)
+    void build() {
+        for (size_t i = 1; i < nodes.size(); i++) {
+            size_t parent = i + (i & (0 - i));
+            if (parent < nodes.size()) {
+                nodes[parent].size += nodes[i].size;
+                nodes[parent].count += nodes[i].count;
+            }
+        }
+    }
+
+    // Deltas wrap like two's complement, so 0 - x removes x
+    void add(uint32_t rank, uint64_t size, uint64_t count) {
+        for (size_t i = static_cast<size_t>(rank) + 1; i < nodes.size(); i += i & (0 - i)) {
+            nodes[i].size += size;
+            nodes[i].count += count;
+        }
+    }
+
+    // Totals over the ranks below rank
+    Node prefix(uint32_t rank) const {
+        Node sum{0, 0};
+        for (size_t i = rank; i > 0; i -= i & (0 - i)) {
+            sum.size += nodes[i].size;
+            sum.count += nodes[i].count;
+        }
+        return sum;
+    }
+};
+
+// Side policies: Compare(a, b) is true when a is the better price
+struct BidSide {
+    using Compare = std::greater<Price>;   // Highest price first
+};
+
+struct AskSide {
+    using Compare = std::less<Price>;      // Lowest price first
+};
+
+// Both level stores answer rank(price, exists): the number of levels strictly
+// better than price, i.e. the depth of an existing level or the depth a new
+// level would take, in O(log n) rather than a walk from the top of the book.
+
+// Node-based level store, kept as the reference implementation for A/B runs:
+// a __gnu_pbds red-black tree whose order-statistics policy maintains
+// subtree sizes, so ranks come straight from the tree.
+template <typename Side>
+class MapLevels : public __gnu_pbds::tree<Price, PriceLevel, typename Side::Compare,
+                                          __gnu_pbds::rb_tree_tag,
+                                          __gnu_pbds::tree_order_statistics_node_update> {
+public:
+    size_t rank(Price price, bool& exists) const {
+        exists = this->find(price) != this->end();
+        return this->order_of_key(price);
+    }
+};
+
+// Contiguous level store: a vector sorted from the worst price to the best,
+// so the touch sits at the back. Levels near the BBO are inserted and erased
+// with short tail moves, the top-N walk reads sequential memory, and the
+// capacity is retained across clear() so steady-state add/cancel does not
+// allocate. Nothing is reserved until the first level arrives, so books for
+// idle instruments stay small.
+//
+// Exposes the subset of the map interface OrderBook uses (the one MapLevels
+// has), with iteration running best-first like MapLevels.
+template <typename Side>
+class LadderLevels {
+public:
+    using value_type = std::pair<Price, PriceLevel>;
+    using iterator = typename std::vector<value_type>::reverse_iterator;
+    using const_iterator = typename std::vector<value_type>::const_reverse_iterator;
+    using reverse_iterator = typename std::vector<value_type>::iterator;
+    using const_reverse_iterator = typename std::vector<value_type>::const_iterator;
+
+    static constexpr size_t INITIAL_CAPACITY = 64;
+
+    // Best-first iteration
+    iterator begin() { return levels.rbegin(); }
+    iterator end() { return levels.rend(); }
+    const_iterator begin() const { return levels.rbegin(); }
+    const_iterator end() const { return levels.rend(); }
+
+    // Worst-first iteration
+    reverse_iterator rbegin() { return levels.begin(); }
+    reverse_iterator rend() { return levels.end(); }
+    const_reverse_iterator rbegin() const { return levels.begin(); }
+    const_reverse_iterator rend() const { return levels.end(); }
+
+    bool empty() const { return levels.empty(); }
+    size_t size() const { return levels.size(); }
+    void clear() { levels.clear(); }
+
+    iterator find(Price price) {
+        size_t index = lower_index(price);
+        if (index == levels.size() || levels[index].first != price) return end();
+        return iterator(levels.begin() + index + 1);
+    }
+
+    const_iterator find(Price price) const {
+        size_t index = lower_index(price);
+        if (index == levels.size() || levels[index].first != price) return end();
+        return const_iterator(levels.begin() + index + 1);
+    }
+
+    // Level at price, inserted empty if it does not exist yet
+    PriceLevel& operator[](Price price) {
+        size_t index = lower_index(price);
+        if (index == levels.size() || levels[index].first != price) {
+            if (levels.capacity() == 0) levels.reserve(INITIAL_CAPACITY);
+            levels.insert(levels.begin() + index, value_type(price, PriceLevel{0, 0, NO_ORDER, NO_ORDER}));
+        }
+        return levels[index].second;
+    }
+
+    void erase(iterator it) { levels.erase(std::next(it).base()); }
+
+    // Rank falls out of the slot index: everything behind it is better
+    size_t rank(Price price, bool& exists) const {
+        size_t index = lower_index(price);
+        exists = index < levels.size() && levels[index].first == price;
+        return levels.size() - index - (exists ? 1 : 0);
+    }
+
+private:
+    // Index of the first slot whose price is not worse than price
+    size_t lower_index(Price price) const {
+        // Best levels are at the back, so check the touch before searching
+        if (!levels.empty() && !better(levels.back().first, price)) {
+            return levels.back().first == price ? levels.size() - 1 : levels.size();
+        }
+        auto it = std::lower_bound(levels.begin(), levels.end(), price,
+                                   [](const value_type& level, Price p) { return better(p, level.first); });
+        return static_cast<size_t>(it - levels.begin());
+    }
+
+    static bool better(Price a, Price b) { return typename Side::Compare()(a, b); }
+
+    std::vector<value_type> levels;
+};
+
+#endif // PRICE_LEVELS_H
@@ -0,0 +1,356 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "book_manager.h"
+#include "checkpoint.h"
+#include "mbo_event.h"
+#include "mbo_reader.h"
+#include "mbo_record.h"
+#include "metrics.h"
+#include "replay_index.h"
+#include "spsc_queue.h"
+#include "tfc_sequencer.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Settings for one replay run
+struct ReplayOptions {
+    BookOptions book;
+    size_t tfc_window = TradeSequencer::DEFAULT_WINDOW;  // Rows a T->F->C sequence may span
+    ReplayMetrics* metrics = nullptr;  // Per-stage timing, off when null
+    // Serial replay only: write a checkpoint to checkpoint_path every
+    // checkpoint_every events, and/or start from the state in resume (the
+    // reader and sink already positioned at its offsets)
+    std::string checkpoint_path;
+    uint64_t checkpoint_every = 0;
+    const Checkpoint* resume = nullptr;
+    // Serial replay only: record a time index with keyframes (opened by the
+    // caller, which also closes it)
+    ReplayIndexWriter* index = nullptr;
+};
+
+// Settings a checkpoint records for a replay from Reader into Sink; a
+// resume must use the same ones
+template <typename Reader, typename Sink>
+CheckpointHeader checkpoint_settings(const ReplayOptions& options) {
+    CheckpointHeader header{};
+    header.input_format = Reader::FORMAT_ID;
+    header.output_format = Sink::FORMAT_ID;
+    header.output_levels = static_cast<uint8_t>(options.book.output_levels);
+    header.changes_only = options.book.changes_only ? 1 : 0;
+    header.track_queues = options.book.track_queues ? 1 : 0;
+    header.tfc_window = options.tfc_window;
+    return header;
+}
+
+// Capture books between events: input_offset is where the next row
+// starts, row_index the index it will get and output_bytes the output
+// before it
+template <typename Reader, typename Sink, typename Book>
+void capture_checkpoint(const ReplayOptions& options, const BookManager<Book>& books, uint64_t input_offset,
+                        uint64_t row_index, uint64_t output_bytes, Checkpoint& checkpoint) {
+    checkpoint.header = checkpoint_settings<Reader, Sink>(options);
+    checkpoint.header.input_offset = input_offset;
+    checkpoint.header.row_index = row_index;
+    checkpoint.header.output_bytes = output_bytes;
+    checkpoint.header.book_count = books.size();
+    checkpoint.payload.clear();
+    CheckpointWriter out(checkpoint.payload);
+    books.save_state(out);
+}
+
+// Flush sink and write a checkpoint of books to options.checkpoint_path
+template <typename Reader, typename Book, typename Sink>
+bool save_checkpoint(const ReplayOptions& options, const BookManager<Book>& books, Sink& sink,
+                     uint64_t input_offset, uint64_t row_index) {
+    if (!sink.flush()) {
+        return false;
+    }
+    Checkpoint checkpoint;
+    capture_checkpoint<Reader, Sink>(options, books, input_offset, row_index, sink.bytes_written(), checkpoint);
+    return checkpoint.save(options.checkpoint_path);
+}
+
+// The index keys of the event an entry points at; CSV rows are decoded
+// here, once per entry. False if the row does not decode.
+inline bool index_keys(const MboEvent& event, ReplayIndexEntry& entry) {
+    entry.ts_event = event.ts_event;
+    entry.sequence = event.sequence;
+    return true;
+}
+
+inline bool index_keys(const MboRecord& record, ReplayIndexEntry& entry) {
+    MboEvent event;
+    return to_mbo_event(record, event) && index_keys(event, entry);
+}
+
+// Add entry (keys filled in) at the point before the next event, with a
+// keyframe of books when one is due. The output need not be flushed: the
+// entry records where the next row will land.
+template <typename Reader, typename Book, typename Sink>
+bool add_index_entry(const ReplayOptions& options, const BookManager<Book>& books, const Sink& sink,
+                     ReplayIndexEntry& entry, uint64_t input_offset, uint64_t row_index) {
+    entry.input_offset = input_offset;
+    entry.row_index = row_index;
+    entry.output_offset = sink.bytes_appended();
+    if (!options.index->keyframe_due()) {
+        return options.index->add(entry, nullptr);
+    }
+    Checkpoint keyframe;
+    capture_checkpoint<Reader, Sink>(options, books, input_offset, row_index, entry.output_offset, keyframe);
+    return options.index->add(entry, &keyframe);
+}
+
+// CSV rows too short to carry an action are skipped; typed events always
+// are complete
+inline bool replayable(const MboRecord& record) { return record.field_count >= 6; }
+inline bool replayable(const MboEvent&) { return true; }
+
+// Step reader to its next row. With metrics, the row that enters the
+// look-ahead window (where it is read and tokenized or decoded) is a parse
+// sample.
+template <typename Reader>
+void advance_reader(Reader& reader, StageMetrics* stats) {
+    if (stats == nullptr) {
+        reader.advance();
+        return;
+    }
+    size_t before = reader.available();
+    StageClock clock(stats);
+    reader.advance();
+    if (reader.available() == before) {
+        clock.lap(STAGE_PARSE, reader.peek(before - 1).action);
+    }
+    stats->set_input_bytes(reader.bytes_read());
+}
+
+// Replay the MBO stream through one Book per instrument, writing one MBP-10
+// row per output event. Reader is MboReader (CSV rows) or DbnReader (typed
+// events); both have the same window interface and Reader::Record is what
+// the sequencer, books and sink are fed.
+//
+// Checkpoints and index entries are only taken where no Trade is held
+// back for T->F->C detection, so the books and the output cover exactly the
+// rows before the reader's position and a resumed run (or a query from a
+// keyframe) continues byte for byte. Returns
+// false if the resume state is malformed or a checkpoint could not be
+// written (the replay itself still runs to the end; checkpointing stops).
+template <typename Book, typename Sink, typename Reader>
+bool reconstruct(Reader& reader, Sink& sink, const ReplayOptions& options) {
+    using Record = typename Reader::Record;
+    BookManager<Book> books(options.book);
+    BasicTradeSequencer<Record> sequencer(options.tfc_window);
+    typename Sink::Row row{};
+    Record fused_record;
+    uint64_t row_index = 0;
+    StageMetrics* stats = options.metrics ? &options.metrics->add_thread() : nullptr;
+
+    if (options.resume != nullptr) {
+        const std::string& payload = options.resume->payload;
+        CheckpointReader in(payload.data(), payload.size());
+        if (!books.load_state(in) || !in.at_end()) {
+            return false;
+        }
+        row_index = options.resume->header.row_index;
+    }
+    bool checkpoints_ok = true;
+    uint64_t checkpoint_every = options.checkpoint_path.empty() ? 0 : options.checkpoint_every;
+    uint64_t events_since_checkpoint = 0;
+    uint64_t index_every = options.index ? options.index->index_every() : 0;
+    uint64_t events_since_entry = index_every;  // The start of the replay is always indexed
+    ReplayIndexEntry entry{};
+
+    auto apply_released = [&] {
+        BasicSequencedEvent<Record> event;
+        while (sequencer.next(event)) {
+            Book& orderbook = books.book_for(*event.record);
+            int depth = 0;
+            char action = event.record->action;
+            StageClock clock(stats);
+            const Record* shown = apply_sequenced_event(orderbook, event, fused_record, depth);
+            clock.lap(STAGE_BOOK, action);
+            if (shown != nullptr) {
+                sink.render(orderbook, *shown, depth, row);
+                clock.lap(STAGE_RENDER, action);
+                sink.emit(row_index++, row);
+                clock.lap(STAGE_WRITE, action);
+            }
+        }
+    };
+
+    // Every event passes through T->F->C detection exactly once
+    for (; reader.available() > 0; advance_reader(reader, stats)) {
+        const Record& current = reader.peek(0);
+        if (!replayable(current)) continue;
+        if (checkpoint_every > 0 && events_since_checkpoint >= checkpoint_every && sequencer.idle()) {
+            events_since_checkpoint = 0;
+            if (!save_checkpoint<Reader>(options, books, sink, reader.position(), row_index)) {
+                checkpoints_ok = false;
+                checkpoint_every = 0;
+            }
+        }
+        events_since_checkpoint++;
+        if (index_every > 0 && events_since_entry >= index_every && sequencer.idle() && index_keys(current, entry)) {
+            events_since_entry = 0;
+            if (!add_index_entry<Reader>(options, books, sink, entry, reader.position(), row_index)) {
+                index_every = 0;  // The writer reports the failure when closed
+            }
+        }
+        events_since_entry++;
+        if (stats) stats->count_event();
+        sequencer.push(current);
+        apply_released();
+    }
+    sequencer.finish();
+    apply_released();
+    return checkpoints_ok;
+}
+
+// Same replay spread over worker_count threads, each owning the books of a
+// disjoint set of instruments.
+//
+// The calling thread reads events, runs T->F->C detection and routes each to its
+// instrument's worker over an SPSC queue, logging the worker id in a route
+// queue. Workers apply events to their books and render rows into per-worker
+// result queues, one result per event. A merger thread replays the route log
+// and pops the next result from each named worker in turn. That restores the
+// input order without timestamps or sorting, so the output is byte-identical
+// to reconstruct().
+template <typename Book, typename Sink, typename Reader>
+void reconstruct_parallel(Reader& reader, Sink& sink, const ReplayOptions& options, size_t worker_count) {
+    using Record = typename Reader::Record;
+    static constexpr size_t QUEUE_DEPTH = 4096;
+    static constexpr uint32_t ROUTE_END = UINT32_MAX;
+
+    struct Event {
+        std::string line;         // Owns the bytes record points into (CSV rows)
+        Record record;
+        std::string cancel_line;  // Fused sequences only
+        Record cancel;
+        bool fused = false;
+        bool end = false;
+    };
+    struct Result {
+        bool has_row = false;
+        char action = '\0';
+        typename Sink::Row row{};
+    };
+
+    std::vector<std::unique_ptr<SpscQueue<Event>>> inputs;
+    std::vector<std::unique_ptr<SpscQueue<Result>>> results;
+    for (size_t i = 0; i < worker_count; i++) {
+        inputs.push_back(std::make_unique<SpscQueue<Event>>(QUEUE_DEPTH));
+        results.push_back(std::make_unique<SpscQueue<Result>>(QUEUE_DEPTH));
+    }
+    SpscQueue<uint32_t> route(QUEUE_DEPTH * worker_count);
+
+    // Every thread records into its own StageMetrics, registered up front
+    ReplayMetrics* metrics = options.metrics;
+    StageMetrics* reader_stats = metrics ? &metrics->add_thread() : nullptr;
+    StageMetrics* merger_stats = metrics ? &metrics->add_thread() : nullptr;
+    std::vector<StageMetrics*> worker_stats(worker_count, nullptr);
+    for (size_t i = 0; metrics != nullptr && i < worker_count; i++) {
+        worker_stats[i] = &metrics->add_thread();
+    }
+
+    // Workers only render; the sink's settings are read-only during the replay
+    const Sink& renderer = sink;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < worker_count; i++) {
+        workers.emplace_back([&input = *inputs[i], &output = *results[i], &renderer, &options, stats = worker_stats[i]] {
+            BookManager<Book> books(options.book);
+            Record fused_record;
+            for (;;) {
+                Event& event = input.front();
+                if (event.end) {
+                    input.pop();
+                    break;
+                }
+                Book& orderbook = books.book_for(event.record);
+                Result& result = output.claim();
+                int depth = 0;
+                BasicSequencedEvent<Record> sequenced{&event.record, event.fused ? &event.cancel : nullptr};
+                StageClock clock(stats);
+                const Record* shown = apply_sequenced_event(orderbook, sequenced, fused_record, depth);
+                clock.lap(STAGE_BOOK, event.record.action);
+                result.has_row = (shown != nullptr);
+                result.action = event.record.action;
+                if (result.has_row) {
+                    renderer.render(orderbook, *shown, depth, result.row);
+                    clock.lap(STAGE_RENDER, event.record.action);
+                }
+                output.publish();
+                input.pop();
+            }
+        });
+    }
+
+    std::thread merger([&] {
+        uint64_t row_index = 0;
+        for (;;) {
+            uint32_t worker = route.front();
+            route.pop();
+            if (worker == ROUTE_END) {
+                break;
+            }
+            Result& result = results[worker]->front();
+            if (result.has_row) {
+                StageClock clock(merger_stats);
+                sink.emit(row_index++, result.row);
+                clock.lap(STAGE_WRITE, result.action);
+            }
+            results[worker]->pop();
+        }
+    });
+
+    BasicTradeSequencer<Record> sequencer(options.tfc_window);
+    auto route_released = [&] {
+        BasicSequencedEvent<Record> released;
+        while (sequencer.next(released)) {
+            const Record& record = *released.record;
+            uint64_t key = BookManager<Book>::book_key(record.publisher_id, record.instrument_id);
+            uint32_t worker = static_cast<uint32_t>(((key * 0x9E3779B97F4A7C15ULL) >> 32) % worker_count);
+
+            // Copy the rows into the slot; the sequencer's buffers are reused
+            Event& event = inputs[worker]->claim();
+            copy_mbo_record(record, event.line, event.record);
+            event.fused = released.fused();
+            if (event.fused) {
+                copy_mbo_record(*released.cancel, event.cancel_line, event.cancel);
+            }
+            event.end = false;
+            inputs[worker]->publish();
+
+            route.claim() = worker;
+            route.publish();
+        }
+    };
+
+    for (; reader.available() > 0; advance_reader(reader, reader_stats)) {
+        const Record& current = reader.peek(0);
+        if (!replayable(current)) continue;
+        if (reader_stats) reader_stats->count_event();
+        sequencer.push(current);
+        route_released();
+    }
+    sequencer.finish();
+    route_released();
+
+    for (auto& input : inputs) {
+        input->claim().end = true;
+        input->publish();
+    }
+    route.claim() = ROUTE_END;
+    route.publish();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    merger.join();
+}
+
+#endif // REPLAY_H
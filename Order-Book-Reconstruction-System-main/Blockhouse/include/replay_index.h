@@ -0,0 +1,123 @@
+#ifndef REPLAY_INDEX_H
+#define REPLAY_INDEX_H
+
+#include "checkpoint.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Sparse time index over a replay, for point-in-time book queries without
+// a pass over the whole output or input (see tools/mbp_query.cpp).
+//
+// Every index_every events the serial replay records an entry: the
+// ts_event and sequence of the next event, where that event starts in the
+// input, and the index and byte offset of the next output row. Seeking the
+// output to output_offset lands on row row_index, the first row of events
+// from ts_event on. Every keyframe_every-th entry (the first one included)
+// also saves a keyframe, the full book state at that point in checkpoint
+// form, so a query loads the last keyframe at or before its time and replays
+// only the input after it.
+//
+// The index file is one ReplayIndexHeader followed by fixed-width entries,
+// all little-endian; keyframes go back to back into path +
+// REPLAY_KEYFRAME_SUFFIX. Entries are only taken between events where no
+// Trade is held back for T->F->C detection, like checkpoints, so a keyframe
+// plus the input from its offset replays exactly as the full run did.
+//
+// Lookups binary-search on ts_event, which relies on the feed being in
+// ts_event order, as MBO data is; an index built from a feed that is not is
+// flagged REPLAY_INDEX_UNORDERED.
+
+static constexpr char REPLAY_INDEX_MAGIC[8] = {'M', 'B', 'P', 'I', 'D', 'X', '0', '1'};
+static constexpr uint16_t REPLAY_INDEX_VERSION = 1;
+static constexpr uint16_t REPLAY_INDEX_UNORDERED = 1;   // Header flag
+static constexpr uint64_t NO_KEYFRAME = UINT64_MAX;
+static constexpr const char* REPLAY_KEYFRAME_SUFFIX = ".keyframes";
+
+struct ReplayIndexHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t entry_size;
+    uint64_t index_every;      // Events between entries
+    uint64_t keyframe_every;   // Entries between keyframes
+};
+static_assert(sizeof(ReplayIndexHeader) == 32, "ReplayIndexHeader layout changed");
+
+struct ReplayIndexEntry {
+    uint64_t ts_event;         // Of the next event; every event before it is no later
+    uint64_t sequence;         // Of the next event
+    uint64_t input_offset;     // Where the next event starts in the input
+    uint64_t row_index;        // Index of the next output row
+    uint64_t output_offset;    // Output bytes before that row
+    uint64_t keyframe_offset;  // Position of this point's keyframe, or NO_KEYFRAME
+};
+static_assert(sizeof(ReplayIndexEntry) == 48, "ReplayIndexEntry layout changed");
+
+// Written by the replay loop (see ReplayOptions::index)
+class ReplayIndexWriter {
+public:
+    static constexpr uint64_t DEFAULT_INDEX_EVERY = 100000;
+    static constexpr uint64_t DEFAULT_KEYFRAME_EVERY = 10;
+
+    // Create path and its keyframe file, replacing old ones
+    bool open(const std::string& path, uint64_t index_every = DEFAULT_INDEX_EVERY,
+              uint64_t keyframe_every = DEFAULT_KEYFRAME_EVERY);
+
+    uint64_t index_every() const { return header.index_every; }
+
+    // Whether the next entry carries a keyframe
+    bool keyframe_due() const { return entry_count % header.keyframe_every == 0; }
+
+    // Append entry, and keyframe (required exactly when keyframe_due())
+    // with entry.keyframe_offset filled in. Returns false once a write fails;
+    // the index is useless from then on.
+    bool add(ReplayIndexEntry entry, Checkpoint* keyframe);
+
+    // Finish both files; false if any write failed
+    bool close();
+
+    bool is_open() const { return index_file.is_open(); }
+    uint64_t entries() const { return entry_count; }
+
+private:
+    std::ofstream index_file;
+    std::ofstream keyframe_file;
+    ReplayIndexHeader header{};
+    uint64_t entry_count = 0;
+    uint64_t keyframe_bytes = 0;
+    uint64_t last_ts_event = 0;
+    bool failed = false;
+};
+
+// A loaded index, for queries
+class ReplayIndex {
+public:
+    // Read path; false if it is missing or not an index. A run that did not
+    // finish leaves an index of the entries written so far.
+    bool load(const std::string& path);
+
+    const ReplayIndexHeader& header() const { return file_header; }
+    const std::vector<ReplayIndexEntry>& entries() const { return entry_list; }
+    bool ordered() const { return (file_header.flags & REPLAY_INDEX_UNORDERED) == 0; }
+
+    // Last entry whose events before it all have ts_event <= ts_event, or
+    // nullptr if ts_event precedes the first event
+    const ReplayIndexEntry* find(uint64_t ts_event) const;
+
+    // Same, among entries with a keyframe; the first entry (the start of
+    // the replay, always a keyframe) when ts_event precedes them all
+    const ReplayIndexEntry* find_keyframe(uint64_t ts_event) const;
+
+    // Read entry's keyframe; false if it is missing or damaged
+    bool load_keyframe(const ReplayIndexEntry& entry, Checkpoint& keyframe);
+
+private:
+    ReplayIndexHeader file_header{};
+    std::vector<ReplayIndexEntry> entry_list;
+    std::ifstream keyframe_file;
+};
+
+#endif // REPLAY_INDEX_H
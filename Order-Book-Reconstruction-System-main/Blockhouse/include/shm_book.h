@@ -0,0 +1,197 @@
+#ifndef SHM_BOOK_H
+#define SHM_BOOK_H
+
+#include "mbp_binary.h"
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Latest book image per instrument in a shared mapping, for consumers in
+// other processes on the same host (see ShmBookPublisher and --publish).
+//
+// The region is a file (e.g. under /dev/shm): one ShmBookHeader, then a
+// power-of-two table of ShmBookSlots addressed by open hashing on the book
+// key. Each slot holds the MbpBinaryRecord of the book's last output row
+// (the event plus the top levels of each side) behind a seqlock: the single
+// writer makes the sequence odd, stores the record words and makes it even
+// again, and a reader copies the words and keeps the copy only if the
+// sequence was even and unchanged around it. Readers never block the
+// writer or each other, and take no locks; a read retries only while it
+// overlaps an update of that same slot.
+//
+// Slots are claimed once and never move, so a reader can find() a book
+// once and read() its slot from then on. Intermediate images of a busy book
+// are overwritten, not queued: readers see the latest one.
+//
+// This header is all a consumer needs (no library): build with
+// g++ -std=c++17 -Iinclude consumer.cpp. POSIX only.
+
+static constexpr char SHM_BOOK_MAGIC[8] = {'M', 'B', 'P', 'S', 'H', 'M', '0', '1'};
+static constexpr uint32_t SHM_BOOK_VERSION = 1;
+static constexpr size_t SHM_BOOK_WORDS = sizeof(MbpBinaryRecord) / sizeof(uint64_t);
+
+static_assert(sizeof(MbpBinaryRecord) % sizeof(uint64_t) == 0, "Images are copied in 8-byte words");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared atomics must be lock-free");
+
+enum ShmBookState : uint32_t {
+    SHM_BOOK_STARTING = 0,
+    SHM_BOOK_LIVE = 1,       // The writer is publishing
+    SHM_BOOK_FINISHED = 2,   // The replay ended; images are final
+};
+
+struct alignas(64) ShmBookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_count;                    // Power of two
+    uint32_t level_count;                   // Levels per side filled in each image (--depth)
+    uint32_t record_size;                   // sizeof(MbpBinaryRecord)
+    std::atomic<uint32_t> state;            // ShmBookState
+    std::atomic<uint32_t> books;            // Slots claimed so far
+    std::atomic<uint64_t> publish_count;    // Images published, all books
+    std::atomic<uint64_t> dropped;          // Images of books that found the table full
+};
+static_assert(sizeof(ShmBookHeader) == 64, "ShmBookHeader layout changed");
+
+struct alignas(64) ShmBookSlot {
+    std::atomic<uint64_t> key;              // 0 while free, else shm_book_key()
+    std::atomic<uint64_t> sequence;         // Odd during an update; 0 until the first image
+    std::atomic<uint64_t> words[SHM_BOOK_WORDS];
+};
+
+// Never 0, so a zeroed slot is free
+inline uint64_t shm_book_key(uint16_t publisher_id, uint32_t instrument_id) {
+    return (uint64_t(1) << 63) | (uint64_t(publisher_id) << 32) | instrument_id;
+}
+
+// First slot probed for key; collisions continue linearly
+inline size_t shm_book_home(uint64_t key, size_t slot_count) {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & (slot_count - 1);
+}
+
+inline size_t shm_book_region_size(size_t slot_count) {
+    return sizeof(ShmBookHeader) + slot_count * sizeof(ShmBookSlot);
+}
+
+// Read-only view of a published region
+class ShmBookReader {
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    ShmBookReader() = default;
+    ~ShmBookReader() { close(); }
+
+    ShmBookReader(const ShmBookReader&) = delete;
+    ShmBookReader& operator=(const ShmBookReader&) = delete;
+
+    // Map path; false if it is missing, not (yet) a live or finished region,
+    // or from another version
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        void* address = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmBookHeader)) {
+            length = static_cast<size_t>(st.st_size);
+            address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        region = static_cast<const char*>(address);
+        const ShmBookHeader& head = header();
+        if (head.state.load(std::memory_order_acquire) == SHM_BOOK_STARTING ||
+            std::memcmp(head.magic, SHM_BOOK_MAGIC, sizeof(head.magic)) != 0 ||
+            head.version != SHM_BOOK_VERSION || head.record_size != sizeof(MbpBinaryRecord) ||
+            length < shm_book_region_size(head.slot_count)) {
+            close();
+            return false;
+        }
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (region != nullptr) {
+            munmap(const_cast<char*>(region), length);
+        }
+#endif
+        region = nullptr;
+        length = 0;
+    }
+
+    bool is_open() const { return region != nullptr; }
+
+    const ShmBookHeader& header() const { return *reinterpret_cast<const ShmBookHeader*>(region); }
+
+    // Images published so far across all books; poll it to notice any update
+    uint64_t publish_count() const { return header().publish_count.load(std::memory_order_acquire); }
+
+    bool finished() const { return header().state.load(std::memory_order_acquire) == SHM_BOOK_FINISHED; }
+
+    // Slot of a book, or NOT_FOUND while it has not been published
+    size_t find(uint16_t publisher_id, uint32_t instrument_id) const {
+        uint64_t key = shm_book_key(publisher_id, instrument_id);
+        size_t slot_count = header().slot_count;
+        size_t index = shm_book_home(key, slot_count);
+        for (size_t probes = 0; probes < slot_count; probes++, index = (index + 1) & (slot_count - 1)) {
+            uint64_t found = slot(index).key.load(std::memory_order_acquire);
+            if (found == key) return index;
+            if (found == 0) break;
+        }
+        return NOT_FOUND;
+    }
+
+    // Copy the latest image in slot index into out. Returns false while the
+    // slot has no image yet; sequence (optional) grows with every update, so
+    // an unchanged value means an unchanged book.
+    bool read(size_t index, MbpBinaryRecord& out, uint64_t* sequence = nullptr) const {
+        const ShmBookSlot& source = slot(index);
+        uint64_t words[SHM_BOOK_WORDS];
+        for (;;) {
+            uint64_t before = source.sequence.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if (before & 1) {
+                continue;  // Mid-update: the writer is a few hundred bytes from done
+            }
+            for (size_t i = 0; i < SHM_BOOK_WORDS; i++) {
+                words[i] = source.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (source.sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&out, words, sizeof(out));
+                if (sequence != nullptr) *sequence = before;
+                return true;
+            }
+        }
+    }
+
+private:
+    const ShmBookSlot& slot(size_t index) const {
+        return reinterpret_cast<const ShmBookSlot*>(region + sizeof(ShmBookHeader))[index];
+    }
+
+    const char* region = nullptr;
+    size_t length = 0;
+};
+
+#endif // SHM_BOOK_H
@@ -0,0 +1,52 @@
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+#include "shm_book.h"
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+// Writer side of a shared book region (see shm_book.h). There must be one
+// publisher per region, and publish() is called from one thread: the slot
+// protocol relies on a single writer. Readers in other processes attach
+// and detach at any time without the publisher noticing.
+class ShmBookPublisher {
+public:
+    static constexpr size_t DEFAULT_SLOTS = 4096;
+
+    ShmBookPublisher() = default;
+    ~ShmBookPublisher();
+
+    ShmBookPublisher(const ShmBookPublisher&) = delete;
+    ShmBookPublisher& operator=(const ShmBookPublisher&) = delete;
+
+    // Create (replacing any old region) and map path with room for slots
+    // books, rounded up to a power of two; levels is recorded for readers
+    bool open(const std::string& path, size_t levels, size_t slots = DEFAULT_SLOTS);
+
+    // Mark the region finished and unmap it; the file stays for late readers
+    bool close();
+
+    bool is_open() const { return header != nullptr; }
+
+    // Replace the image of record's book. A book that finds every slot taken
+    // is counted in the header's dropped counter instead.
+    void publish(const MbpBinaryRecord& record);
+
+    uint64_t published() const { return publish_total; }
+    uint64_t dropped() const { return dropped_total; }
+
+private:
+    ShmBookSlot* claim(uint64_t key);
+
+    ShmBookHeader* header = nullptr;
+    ShmBookSlot* slots = nullptr;
+    size_t slot_count = 0;
+    size_t length = 0;
+    uint64_t publish_total = 0;
+    uint64_t dropped_total = 0;
+    std::unordered_map<uint64_t, ShmBookSlot*> slot_of;   // Writer-side cache of claimed slots; nullptr: none left
+};
+
+#endif // SHM_PUBLISHER_H
@@ -0,0 +1,26 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Delimiter scanning kernels used by the CSV front end.
+// AVX2, SSE2 and scalar variants are compiled into every build; the best one
+// the CPU supports is picked once at startup.
+
+// First occurrence of c in [begin, end), or end if there is none
+const char* scan_byte(const char* begin, const char* end, char c);
+
+// Offsets (relative to begin) of up to max occurrences of c in [begin, end).
+// Returns the number of offsets written.
+size_t scan_all_bytes(const char* begin, const char* end, char c, uint32_t* offsets, size_t max);
+
+// Force a kernel set: "avx2", "sse2" or "scalar". Returns false if the name
+// is unknown or the CPU lacks the instructions.
+bool select_scan_kernels(const std::string& isa);
+
+// Name of the kernel set in use
+const char* active_scan_kernels();
+
+#endif // SIMD_SCAN_H
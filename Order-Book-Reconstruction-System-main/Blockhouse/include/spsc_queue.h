@@ -0,0 +1,77 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// Bounded lock-free single-producer/single-consumer ring.
+//
+// Slots are constructed once and handed out in place: the producer fills
+// claim() then publish()es it, the consumer reads front() then pop()s it. A
+// slot's heap storage (e.g. a std::string) is reused by later items, so the
+// steady state does not allocate. Both sides spin briefly and then yield when
+// the ring is full or empty.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer: next free slot, waiting while the ring is full
+    T& claim() {
+        size_t h = head.load(std::memory_order_relaxed);
+        for (unsigned spins = 0; h - tail_cache >= slots.size(); spins++) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h - tail_cache >= slots.size()) pause(spins);
+        }
+        return slots[h & mask];
+    }
+
+    // Producer: make the claimed slot visible to the consumer
+    void publish() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: oldest published slot, waiting while the ring is empty
+    T& front() {
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (unsigned spins = 0; t == head_cache; spins++) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t == head_cache) pause(spins);
+        }
+        return slots[t & mask];
+    }
+
+    // Consumer: hand the front slot back to the producer
+    void pop() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    static size_t round_up(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    static void pause(unsigned spins) {
+        if (spins >= 64) std::this_thread::yield();
+    }
+
+    std::vector<T> slots;
+    const size_t mask;
+
+    // Producer-owned line: its index and its last view of the consumer's
+    alignas(64) std::atomic<size_t> head{0};
+    size_t tail_cache = 0;
+
+    // Consumer-owned line
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t head_cache = 0;
+};
+
+#endif // SPSC_QUEUE_H
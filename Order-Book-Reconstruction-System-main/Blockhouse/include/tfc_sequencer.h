@@ -0,0 +1,105 @@
+#ifndef TFC_SEQUENCER_H
+#define TFC_SEQUENCER_H
+
+#include "mbo_event.h"
+#include "mbo_record.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// One unit of work for a book: a single event, or a Trade fused with the
+// Cancel that carries its effect on the book
+template <typename Record>
+struct BasicSequencedEvent {
+    const Record* record;   // The event; for a fused sequence, the Trade
+    const Record* cancel;   // The resolving Cancel, or nullptr
+
+    bool fused() const { return cancel != nullptr; }
+};
+
+// Streaming T->F->C detection.
+//
+// Each parsed event is pushed once. A Trade is held back while it may still
+// open a sequence: a Fill for the same instrument must follow immediately,
+// then a Cancel for that instrument within the window (the Trade's row
+// counts as the first). Rows in between are held in order; an Add or another
+// Trade in between, or running out of window, means there is no sequence and
+// everything held is released as plain events. A resolved sequence releases
+// the rows in between followed by one fused event in the Cancel's place;
+// the Fill itself has no book effect and is dropped.
+//
+// Released events are drained with next() and point into the sequencer's
+// buffers or the pushed record, so they stay valid only until the next
+// push() or finish().
+//
+// Record is a tokenized CSV row (MboRecord) or a typed MboEvent; held rows
+// are kept with copy_mbo_record().
+template <typename Record>
+class BasicTradeSequencer {
+public:
+    using Event = BasicSequencedEvent<Record>;
+
+    // Matches the original five-row lookahead: T, F, then C no more than two
+    // rows later
+    static constexpr size_t DEFAULT_WINDOW = 5;
+    static constexpr size_t MIN_WINDOW = 3;
+
+    explicit BasicTradeSequencer(size_t window = DEFAULT_WINDOW);
+
+    // Feed the next event in stream order
+    void push(const Record& record);
+
+    // End of stream: release whatever is still held
+    void finish();
+
+    // Pop the next released event
+    bool next(Event& event);
+
+    // Nothing held back or waiting to be drained, i.e. every pushed event
+    // has been released and popped
+    bool idle() const { return pending.empty() && ready_head == ready.size(); }
+
+private:
+    struct Slot {
+        std::string line;
+        Record record;
+    };
+
+    void accept(const Record& record);
+    void release_pending();
+    const Record& hold(const Record& record);
+    void emit(const Record* record, const Record* cancel = nullptr);
+
+    size_t window;
+    std::vector<Slot> slots;                 // Ring of owned copies, window + 1 deep
+    size_t next_slot = 0;
+    std::vector<const Record*> pending;      // Held rows, starting with the Trade
+    std::vector<Event> ready;
+    size_t ready_head = 0;
+};
+
+using SequencedEvent = BasicSequencedEvent<MboRecord>;
+using TradeSequencer = BasicTradeSequencer<MboRecord>;
+
+extern template class BasicTradeSequencer<MboRecord>;
+extern template class BasicTradeSequencer<MboEvent>;
+
+// Apply one sequenced event to its book. Returns the record the row reports
+// (for a fused sequence, the Trade carrying the Cancel's side, built in
+// scratch), or nullptr when the event produces no row.
+template <typename Book, typename Record>
+const Record* apply_sequenced_event(Book& orderbook, const BasicSequencedEvent<Record>& event, Record& scratch, int& depth) {
+    depth = 0;
+    if (event.fused()) {
+        if (!orderbook.apply_tfc_sequence(*event.record, *event.cancel, depth)) {
+            return nullptr;
+        }
+        scratch = *event.record;
+        scratch.side = event.cancel->side;  // The side whose change the row reflects
+        return &scratch;
+    }
+    // COMPANY REQUIREMENT: Only output when there's a significant change
+    return orderbook.apply_mbo_action(*event.record, depth) ? event.record : nullptr;
+}
+
+#endif // TFC_SEQUENCER_H
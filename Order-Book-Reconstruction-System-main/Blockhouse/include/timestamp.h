@@ -0,0 +1,20 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+// Longest output of format_timestamp: "YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ"
+static constexpr size_t TIMESTAMP_TEXT_MAX = 32;
+
+// Parse an ISO-8601 UTC timestamp ("2025-07-17T08:05:03.360677248Z", up to
+// nine fractional digits) or a plain integer count into nanoseconds since
+// the Unix epoch. Returns false on malformed input.
+bool parse_timestamp(std::string_view text, uint64_t& nanos);
+
+// Write nanos as "YYYY-MM-DDTHH:MM:SS.nnnnnnnnnZ" into out, which must hold
+// TIMESTAMP_TEXT_MAX bytes. Returns the length.
+size_t format_timestamp(uint64_t nanos, char* out);
+
+#endif // TIMESTAMP_H
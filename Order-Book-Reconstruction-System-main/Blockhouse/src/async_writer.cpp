@@ -0,0 +1,214 @@
+#include "../include/async_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+bool AsyncFileWriter::open(const std::string& filename, bool direct, uint64_t keep_bytes) {
+    close();
+
+    int flags = O_WRONLY | O_CREAT | O_BINARY | (keep_bytes > 0 ? 0 : O_TRUNC);
+    direct_mode = false;
+#ifdef O_DIRECT
+    // Appending from an unaligned offset rules O_DIRECT out
+    if (direct && keep_bytes % ALIGNMENT == 0) {
+        fd = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        direct_mode = (fd >= 0);
+    }
+#else
+    (void)direct;
+#endif
+    if (fd < 0) {
+        fd = ::open(filename.c_str(), flags, 0644);
+    }
+    if (fd < 0) {
+        return false;
+    }
+    if (keep_bytes > 0 && !keep_prefix(keep_bytes)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    for (char*& block : blocks) {
+        block = static_cast<char*>(::operator new(BLOCK_SIZE + MAX_RESERVE, std::align_val_t(ALIGNMENT)));
+    }
+    for (size_t i = 0; i < BLOCK_COUNT; i++) {
+        queued_bytes[i] = 0;
+        final_block[i] = false;
+    }
+    current = 0;
+    fill = 0;
+    handed_off = keep_bytes;
+    stopping = false;
+    failed = false;
+    flushed.store(keep_bytes, std::memory_order_relaxed);
+    writer = std::thread(&AsyncFileWriter::run, this);
+    return true;
+}
+
+bool AsyncFileWriter::keep_prefix(uint64_t keep_bytes) {
+#ifdef _WIN32
+    __int64 size = _lseeki64(fd, 0, SEEK_END);
+    return size >= 0 && static_cast<uint64_t>(size) >= keep_bytes &&
+           _chsize_s(fd, static_cast<__int64>(keep_bytes)) == 0 &&
+           _lseeki64(fd, static_cast<__int64>(keep_bytes), SEEK_SET) >= 0;
+#else
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    return size >= 0 && static_cast<uint64_t>(size) >= keep_bytes &&
+           ::ftruncate(fd, static_cast<off_t>(keep_bytes)) == 0 &&
+           ::lseek(fd, static_cast<off_t>(keep_bytes), SEEK_SET) >= 0;
+#endif
+}
+
+void AsyncFileWriter::write(const char* data, size_t bytes) {
+    while (bytes > 0) {
+        size_t chunk = std::min(bytes, MAX_RESERVE);
+        std::memcpy(reserve(chunk), data, chunk);
+        commit(chunk);
+        data += chunk;
+        bytes -= chunk;
+    }
+}
+
+void AsyncFileWriter::submit() {
+    // Queue exactly BLOCK_SIZE bytes; whatever spilled past them carries
+    // over to the next block, which the writer thread never touches
+    size_t spill = fill - BLOCK_SIZE;
+    char* full = blocks[current];
+    size_t next = (current + 1) % BLOCK_COUNT;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        queued_bytes[current] = BLOCK_SIZE;
+        changed.notify_all();
+        changed.wait(lock, [&] { return queued_bytes[next] == 0; });
+    }
+    std::memcpy(blocks[next], full + BLOCK_SIZE, spill);
+    handed_off += BLOCK_SIZE;
+    current = next;
+    fill = spill;
+}
+
+bool AsyncFileWriter::flush() {
+    if (fd < 0) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fill > 0) {
+        // The partial block goes out like a final one; filling resumes in
+        // the next block, which is where the writer thread looks next
+        queued_bytes[current] = fill;
+        final_block[current] = true;
+        changed.notify_all();
+    }
+    changed.wait(lock, [&] {
+        for (size_t bytes : queued_bytes) {
+            if (bytes != 0) return false;
+        }
+        return true;
+    });
+    if (fill > 0) {
+        handed_off += fill;
+        current = (current + 1) % BLOCK_COUNT;
+        fill = 0;
+    }
+    return !failed;
+}
+
+bool AsyncFileWriter::close() {
+    if (fd < 0) {
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fill > 0) {
+            queued_bytes[current] = fill;
+            final_block[current] = true;
+        }
+        stopping = true;
+        changed.notify_all();
+    }
+    writer.join();
+
+    bool ok = !failed;
+    if (::close(fd) != 0) {
+        ok = false;
+    }
+    fd = -1;
+    for (char*& block : blocks) {
+        ::operator delete(block, std::align_val_t(ALIGNMENT));
+        block = nullptr;
+    }
+    fill = 0;
+    return ok;
+}
+
+void AsyncFileWriter::run() {
+    // Blocks are written in the order they were filled
+    size_t next = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [&] { return queued_bytes[next] != 0 || stopping; });
+        if (queued_bytes[next] == 0) {
+            break;  // Stopping with nothing left queued
+        }
+
+        size_t bytes = queued_bytes[next];
+        bool last = final_block[next];
+        bool skip = failed;  // After a failure blocks are dropped, not written
+        lock.unlock();
+        size_t written = skip ? 0 : write_block(blocks[next], bytes, last);
+        lock.lock();
+
+        // Only bytes that reached the file count toward bytes_written()
+        flushed.fetch_add(written, std::memory_order_relaxed);
+        if (written != bytes) {
+            failed = true;  // Keep draining so the caller never blocks on a dead writer
+        }
+        queued_bytes[next] = 0;
+        final_block[next] = false;
+        changed.notify_all();
+        next = (next + 1) % BLOCK_COUNT;
+    }
+}
+
+size_t AsyncFileWriter::write_block(const char* data, size_t bytes, bool last) {
+#ifdef O_DIRECT
+    if (last && direct_mode && bytes % ALIGNMENT != 0) {
+        // The unaligned tail of the file cannot go through O_DIRECT
+        int flags = fcntl(fd, F_GETFL);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) != 0) {
+            return 0;
+        }
+    }
+#else
+    (void)last;
+#endif
+    size_t done = 0;
+    while (done < bytes) {
+        auto written = ::write(fd, data + done, static_cast<unsigned>(bytes - done));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        done += static_cast<size_t>(written);
+    }
+    return done;
+}
@@ -0,0 +1,136 @@
+#include "../include/checkpoint.h"
+#include <cstdio>
+#include <fstream>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+namespace {
+
+uint64_t fnv1a(const std::string& bytes) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char byte : bytes) {
+        hash = (hash ^ byte) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Bytes between the read position and the end of the stream; 0 when the
+// stream cannot tell
+uint64_t remaining_bytes(std::istream& in) {
+    std::streampos position = in.tellg();
+    if (position < 0 || !in.seekg(0, std::ios::end)) {
+        return 0;
+    }
+    std::streampos end = in.tellg();
+    in.seekg(position);
+    return end > position ? static_cast<uint64_t>(end - position) : 0;
+}
+
+// Force a written file's data to disk
+bool sync_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_BINARY);
+    if (fd < 0) {
+        return false;
+    }
+#ifdef _WIN32
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+#else
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return ok;
+}
+
+// Make a rename inside path's directory durable; Windows has no equivalent
+// and commits the rename with the file system's own metadata writes
+void sync_parent_directory(const std::string& path) {
+#ifndef _WIN32
+    size_t slash = path.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+} // namespace
+
+bool Checkpoint::write(std::ostream& out) {
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.payload_size = payload.size();
+    header.payload_checksum = fnv1a(payload);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    return out.good();
+}
+
+bool Checkpoint::read(std::istream& in) {
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION) {
+        return false;
+    }
+    // A corrupt size must not drive the allocation: the payload has to fit
+    // in what is left of the file, and the checksum rejects the rest
+    if (header.payload_size > remaining_bytes(in)) {
+        return false;
+    }
+    payload.resize(header.payload_size);
+    if (!in.read(&payload[0], static_cast<std::streamsize>(payload.size()))) {
+        return false;
+    }
+    return fnv1a(payload) == header.payload_checksum;
+}
+
+bool Checkpoint::save(const std::string& path) {
+    // The previous checkpoint is only replaced once the new one is complete
+    // on disk; a failed write (a full disk on close, say) leaves it in place
+    std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    write(out);
+    out.close();
+    if (out.fail() || !sync_file(temporary)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename() does not replace on Windows
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    sync_parent_directory(path);
+    return true;
+}
+
+bool Checkpoint::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return in.is_open() && read(in);
+}
+
+bool Checkpoint::exists(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return in.is_open();
+}
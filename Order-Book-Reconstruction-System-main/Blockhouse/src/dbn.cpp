@@ -0,0 +1,214 @@
+#include "../include/dbn.h"
+#include "../include/timestamp.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+constexpr size_t DATASET_CSTR_LEN = 16;
+constexpr size_t SYMBOL_CSTR_LEN_V1 = 22;
+constexpr size_t SYMBOL_CSTR_LEN = 71;
+constexpr size_t RESERVED_LEN_V1 = 47;
+constexpr size_t RESERVED_LEN = 53;
+constexpr uint64_t NANOS_PER_DAY = 86400ULL * 1000000000ULL;
+
+// Bounds-checked little-endian reads over the metadata block
+class MetadataCursor {
+public:
+    MetadataCursor(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (static_cast<size_t>(end - cursor) < sizeof(T)) return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    // Fixed-width, NUL-padded string
+    bool get_cstr(size_t width, std::string_view& text) {
+        if (static_cast<size_t>(end - cursor) < width) return false;
+        const void* nul = std::memchr(cursor, '\0', width);
+        size_t length = nul ? static_cast<size_t>(static_cast<const char*>(nul) - cursor) : width;
+        text = std::string_view(cursor, length);
+        cursor += width;
+        return true;
+    }
+
+    bool skip(size_t bytes) {
+        if (static_cast<size_t>(end - cursor) < bytes) return false;
+        cursor += bytes;
+        return true;
+    }
+
+private:
+    const char* cursor;
+    const char* end;
+};
+
+// A u32-counted list of symbols (requested, partial, not found); unused here
+bool skip_symbol_list(MetadataCursor& in, size_t symbol_len) {
+    uint32_t count = 0;
+    return in.get(count) && in.skip(static_cast<size_t>(count) * symbol_len);
+}
+
+bool parse_instrument_id(std::string_view text, uint32_t& id) {
+    auto result = std::from_chars(text.data(), text.data() + text.size(), id);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// YYYYMMDD of the UTC day containing nanos
+uint32_t date_number(uint64_t nanos) {
+    char text[TIMESTAMP_TEXT_MAX];
+    format_timestamp(nanos, text);
+    uint32_t date = 0;
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        date = date * 10 + static_cast<uint32_t>(text[i] - '0');
+    }
+    return date;
+}
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_cstr(std::string& out, std::string_view text, size_t width) {
+    size_t length = std::min(text.size(), width - 1);  // Always NUL-terminated
+    out.append(text.data(), length);
+    out.append(width - length, '\0');
+}
+
+} // namespace
+
+bool decode_dbn_metadata(const char* data, size_t size, DbnMetadata& metadata, size_t& length) {
+    if (size < DBN_PRELUDE_SIZE || std::memcmp(data, DBN_MAGIC, sizeof(DBN_MAGIC)) != 0) {
+        return false;
+    }
+    uint8_t version = static_cast<uint8_t>(data[3]);
+    uint32_t metadata_size = 0;
+    std::memcpy(&metadata_size, data + 4, sizeof(metadata_size));
+    length = DBN_PRELUDE_SIZE + metadata_size;
+    if (version < DBN_VERSION_MIN || version > DBN_VERSION_MAX || metadata_size > DBN_METADATA_MAX ||
+        size < length) {
+        return false;
+    }
+
+    metadata = DbnMetadata{};
+    metadata.version = version;
+    MetadataCursor in(data + DBN_PRELUDE_SIZE, metadata_size);
+    std::string_view dataset;
+    uint64_t limit = 0;
+    uint8_t ts_out = 0;
+    if (!in.get_cstr(DATASET_CSTR_LEN, dataset) || !in.get(metadata.schema) ||
+        !in.get(metadata.start) || !in.get(metadata.end) || !in.get(limit)) {
+        return false;
+    }
+    metadata.dataset = std::string(dataset);
+    if (version == 1 && !in.skip(sizeof(uint64_t))) {  // record_count, dropped after v1
+        return false;
+    }
+    if (!in.get(metadata.stype_in) || !in.get(metadata.stype_out) || !in.get(ts_out)) {
+        return false;
+    }
+    metadata.ts_out = (ts_out != 0);
+    size_t symbol_len = SYMBOL_CSTR_LEN_V1;
+    if (version > 1) {
+        uint16_t len = 0;
+        if (!in.get(len) || len == 0) return false;
+        symbol_len = len;
+    }
+    uint32_t schema_definition_size = 0;
+    if (!in.skip(version == 1 ? RESERVED_LEN_V1 : RESERVED_LEN) ||
+        !in.get(schema_definition_size) || !in.skip(schema_definition_size)) {
+        return false;
+    }
+    for (int list = 0; list < 3; list++) {
+        if (!skip_symbol_list(in, symbol_len)) return false;
+    }
+
+    // Symbology: raw symbol -> [(start date, end date, symbol)]
+    uint32_t mapping_count = 0;
+    if (!in.get(mapping_count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < mapping_count; i++) {
+        std::string_view raw_symbol;
+        uint32_t interval_count = 0;
+        if (!in.get_cstr(symbol_len, raw_symbol) || !in.get(interval_count)) {
+            return false;
+        }
+        for (uint32_t j = 0; j < interval_count; j++) {
+            uint32_t start_date = 0, end_date = 0;
+            std::string_view symbol;
+            if (!in.get(start_date) || !in.get(end_date) || !in.get_cstr(symbol_len, symbol)) {
+                return false;
+            }
+            uint32_t id = 0;
+            if (metadata.stype_out == DBN_STYPE_INSTRUMENT_ID && parse_instrument_id(symbol, id)) {
+                metadata.symbols[id] = std::string(raw_symbol);
+            } else if (metadata.stype_in == DBN_STYPE_INSTRUMENT_ID && parse_instrument_id(raw_symbol, id)) {
+                metadata.symbols[id] = std::string(symbol);
+            }
+        }
+    }
+    return true;
+}
+
+void encode_dbn_metadata(const DbnMetadata& metadata, std::string& out) {
+    std::string body;
+    put_cstr(body, metadata.dataset, DATASET_CSTR_LEN);
+    put(body, metadata.schema);
+    put(body, metadata.start);
+    put(body, metadata.end);
+    put(body, uint64_t{0});                          // limit: none
+    put(body, metadata.stype_in);
+    put(body, metadata.stype_out);
+    put(body, static_cast<uint8_t>(metadata.ts_out ? 1 : 0));
+    put(body, static_cast<uint16_t>(SYMBOL_CSTR_LEN));
+    body.append(RESERVED_LEN, '\0');
+    put(body, uint32_t{0});                          // No schema definition
+    for (int list = 0; list < 3; list++) {
+        put(body, uint32_t{0});                      // Requested, partial, not found
+    }
+
+    // One interval per instrument covering the whole file; end dates are exclusive
+    uint64_t last = (metadata.end == UINT64_MAX || metadata.end <= metadata.start) ? metadata.start : metadata.end - 1;
+    uint32_t start_date = date_number(metadata.start);
+    uint32_t end_date = date_number(last + NANOS_PER_DAY);
+    std::vector<uint32_t> ids;
+    for (const auto& entry : metadata.symbols) {
+        ids.push_back(entry.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    put(body, static_cast<uint32_t>(ids.size()));
+    for (uint32_t id : ids) {
+        char id_text[16];
+        auto result = std::to_chars(id_text, id_text + sizeof(id_text), id);
+        put_cstr(body, metadata.symbols.at(id), SYMBOL_CSTR_LEN);
+        put(body, uint32_t{1});
+        put(body, start_date);
+        put(body, end_date);
+        put_cstr(body, std::string_view(id_text, static_cast<size_t>(result.ptr - id_text)), SYMBOL_CSTR_LEN);
+    }
+
+    // The body is padded so the first record is 8-byte aligned
+    body.append((8 - (DBN_PRELUDE_SIZE + body.size()) % 8) % 8, '\0');
+    out.append(DBN_MAGIC, sizeof(DBN_MAGIC));
+    out.push_back(static_cast<char>(DBN_VERSION));
+    put(out, static_cast<uint32_t>(body.size()));
+    out += body;
+}
+
+bool is_dbn_file(const std::string& filename) {
+    std::ifstream input(filename, std::ios::binary);
+    char magic[4] = {};
+    if (!input.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return std::memcmp(magic, DBN_MAGIC, sizeof(DBN_MAGIC)) == 0 ||
+           std::memcmp(magic, ZSTD_FRAME_MAGIC, sizeof(ZSTD_FRAME_MAGIC)) == 0;
+}
@@ -0,0 +1,195 @@
+#include "../include/dbn_reader.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+
+// Streaming decompressor over the compressed file; concatenated frames are
+// read back to back
+struct DbnReader::ZstdSource {
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    std::vector<char> compressed = std::vector<char>(ZSTD_DStreamInSize());
+    ZSTD_inBuffer in{compressed.data(), 0, 0};
+    bool failed = false;
+
+    ~ZstdSource() { ZSTD_freeDStream(stream); }
+
+    size_t read(std::ifstream& file, char* out, size_t capacity) {
+        ZSTD_outBuffer output{out, capacity, 0};
+        while (output.pos < capacity && !failed) {
+            if (in.pos == in.size) {
+                file.read(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+                in.size = static_cast<size_t>(file.gcount());
+                in.pos = 0;
+                if (in.size == 0) {
+                    break;
+                }
+            }
+            size_t result = ZSTD_decompressStream(stream, &output, &in);
+            failed = ZSTD_isError(result) != 0;
+        }
+        return output.pos;
+    }
+};
+#else
+struct DbnReader::ZstdSource {};
+#endif
+
+DbnReader::DbnReader(const std::string& filename, bool use_mmap, uint64_t start_offset) {
+    if (!open_source(filename, use_mmap) || !read_metadata()) {
+        return;
+    }
+    if (header.schema != DBN_SCHEMA_MBO && header.schema != DBN_SCHEMA_MIXED) {
+        failure = "not an MBO file (DBN schema " + std::to_string(header.schema) + ")";
+        return;
+    }
+    if (start_offset > bytes && !skip_to(start_offset)) {
+        failure = "resume offset is past the end of the stream";
+        return;
+    }
+    opened = true;
+    fill();
+}
+
+DbnReader::~DbnReader() = default;
+
+bool DbnReader::open_source(const std::string& filename, bool use_mmap) {
+    input.open(filename, std::ios::binary);
+    if (!input.is_open()) {
+        failure = "cannot open file";
+        return false;
+    }
+    char magic[sizeof(ZSTD_FRAME_MAGIC)] = {};
+    input.read(magic, sizeof(magic));
+    input.clear();
+    input.seekg(0);
+    if (std::memcmp(magic, ZSTD_FRAME_MAGIC, sizeof(ZSTD_FRAME_MAGIC)) == 0) {
+#ifdef HAVE_ZSTD
+        zstd = std::make_unique<ZstdSource>();
+#else
+        failure = "zstd-compressed input needs a build with HAVE_ZSTD=1";
+        return false;
+#endif
+    } else if (use_mmap && mapping.open(filename)) {
+        input.close();
+        cursor = mapping.data();
+        limit = cursor + mapping.size();
+        source_size = mapping.size();
+        return true;
+    } else {
+        input.seekg(0, std::ios::end);
+        std::streampos end = input.tellg();
+        source_size = end > 0 ? static_cast<uint64_t>(end) : 0;
+        input.seekg(0);
+    }
+    buffer.resize(BLOCK_SIZE);
+    cursor = limit = buffer.data();
+    return true;
+}
+
+bool DbnReader::read_metadata() {
+    // The prelude gives the length of the rest of the block
+    size_t length = 0;
+    if (!ensure(DBN_PRELUDE_SIZE) || std::memcmp(cursor, DBN_MAGIC, sizeof(DBN_MAGIC)) != 0) {
+        failure = "not a DBN file";
+        return false;
+    }
+    uint8_t version = static_cast<uint8_t>(cursor[3]);
+    if (version < DBN_VERSION_MIN || version > DBN_VERSION_MAX) {
+        failure = "unsupported DBN version " + std::to_string(version);
+        return false;
+    }
+    // The length comes from the file: check it against what the file can
+    // hold before the buffer grows to it
+    uint32_t metadata_size = 0;
+    std::memcpy(&metadata_size, cursor + 4, sizeof(metadata_size));
+    bool fits = metadata_size <= DBN_METADATA_MAX &&
+                (source_size == 0 || DBN_PRELUDE_SIZE + metadata_size <= source_size);
+    if (!fits || !ensure(DBN_PRELUDE_SIZE + metadata_size) ||
+        !decode_dbn_metadata(cursor, static_cast<size_t>(limit - cursor), header, length)) {
+        failure = "damaged DBN metadata";
+        return false;
+    }
+    cursor += length;
+    bytes = length;
+    return true;
+}
+
+bool DbnReader::skip_to(uint64_t offset) {
+    if (mapping.is_open()) {
+        if (offset > mapping.size()) return false;
+        cursor = mapping.data() + offset;
+    } else if (!zstd) {
+        input.seekg(static_cast<std::streamoff>(offset));
+        cursor = limit = buffer.data();
+    } else {
+        // A compressed stream can only be decompressed up to the offset
+        while (bytes < offset) {
+            if (!ensure(1)) return false;
+            size_t step = static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(limit - cursor), offset - bytes));
+            cursor += step;
+            bytes += step;
+        }
+    }
+    bytes = offset;
+    return true;
+}
+
+bool DbnReader::ensure(size_t needed) {
+    while (static_cast<size_t>(limit - cursor) < needed) {
+        if (mapping.is_open() || exhausted) {
+            return false;
+        }
+        // Move the unread tail to the front and top the block back up
+        size_t kept = static_cast<size_t>(limit - cursor);
+        std::memmove(buffer.data(), cursor, kept);
+        if (buffer.size() < needed) {
+            buffer.resize(needed);
+        }
+        size_t got = read_source(buffer.data() + kept, buffer.size() - kept);
+        cursor = buffer.data();
+        limit = cursor + kept + got;
+        exhausted = (got == 0);
+    }
+    return true;
+}
+
+size_t DbnReader::read_source(char* out, size_t capacity) {
+#ifdef HAVE_ZSTD
+    if (zstd) {
+        return zstd->read(input, out, capacity);
+    }
+#endif
+    input.read(out, static_cast<std::streamsize>(capacity));
+    return static_cast<size_t>(input.gcount());
+}
+
+void DbnReader::advance() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % WINDOW;
+    count--;
+    fill();
+}
+
+void DbnReader::fill() {
+    while (count < WINDOW && ensure(sizeof(DbnRecordHeader))) {
+        // The header's length covers any trailing fields (ts_out, newer versions)
+        size_t record_size = static_cast<size_t>(static_cast<uint8_t>(cursor[0])) * 4;
+        if (record_size < sizeof(DbnRecordHeader) || !ensure(record_size)) {
+            break;  // Damaged or truncated tail
+        }
+        if (static_cast<uint8_t>(cursor[1]) == DBN_RTYPE_MBO && record_size >= sizeof(DbnMboMsg)) {
+            DbnMboMsg msg;
+            std::memcpy(&msg, cursor, sizeof(msg));
+            Slot& slot = ring[(head + count) % WINDOW];
+            to_mbo_event(msg, slot.event);
+            slot.offset = bytes;
+            count++;
+        }
+        cursor += record_size;
+        bytes += record_size;
+    }
+}
@@ -0,0 +1,299 @@
+#include "../include/feed_generator.h"
+#include "../include/price.h"
+#include "../include/timestamp.h"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+constexpr int64_t TICK = 10000000;              // 0.01 in 1e-9 price units
+constexpr int64_t START_MID = 10000;            // 100.00
+constexpr size_t ORDERS_PER_LEVEL = 4;
+constexpr double REVERSION_PER_TICK = 0.01;     // Extra odds of a trade pushing the mid back, per tick away
+constexpr uint64_t FEED_START_NS = 1752739200000000000ULL;  // 2025-07-17T08:00:00Z
+constexpr uint16_t PUBLISHER_ID = 2;
+constexpr uint32_t FIRST_INSTRUMENT_ID = 1000;
+
+void append_uint(std::string& out, uint64_t value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    out.append(text, static_cast<size_t>(result.ptr - text));
+}
+
+// Prices are written the way the input has them: nine decimals
+void append_price(std::string& out, int64_t price) {
+    if (price < 0) {
+        out.push_back('-');
+        price = -price;
+    }
+    append_uint(out, static_cast<uint64_t>(price / PRICE_SCALE));
+    out.push_back('.');
+    char digits[9];
+    int64_t fraction = price % PRICE_SCALE;
+    for (int i = 8; i >= 0; i--) {
+        digits[i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    out.append(digits, sizeof(digits));
+}
+
+} // namespace
+
+const char* const MboFeedGenerator::HEADER =
+    "ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,price,size,channel_id,order_id,flags,ts_in_delta,sequence,symbol";
+
+MboFeedGenerator::MboFeedGenerator(const FeedProfile& feed_profile)
+    : profile(feed_profile),
+      rng(feed_profile.seed),
+      touch_distance(1.0 / (1.0 + static_cast<double>(std::max<size_t>(feed_profile.depth, 1)) / 4.0)),
+      gap_ns(std::max(feed_profile.events_per_second, 1.0) / 1e9),
+      target_orders(std::max<size_t>(feed_profile.depth, 1) * ORDERS_PER_LEVEL * 2),
+      ts_event(FEED_START_NS) {
+    uint32_t count = std::max<uint32_t>(profile.instruments, 1);
+    double cumulative = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        Instrument instrument;
+        instrument.instrument_id = FIRST_INSTRUMENT_ID + i;
+        instrument.symbol = "SYN" + std::to_string(i);
+        instrument.anchor = START_MID + static_cast<int64_t>(i) * 100;
+        instrument.mid = instrument.anchor;
+        instruments.push_back(std::move(instrument));
+
+        // Activity falls off like 1/rank, as it does across a real universe
+        cumulative += 1.0 / static_cast<double>(i + 1);
+        instrument_weights.push_back(cumulative);
+    }
+    for (double& weight : instrument_weights) {
+        weight /= cumulative;
+    }
+
+    // Every book starts from a reset, like a real session
+    for (Instrument& instrument : instruments) {
+        plan_reset(instrument);
+    }
+}
+
+bool MboFeedGenerator::next(std::string& out) {
+    if (rows >= profile.events) {
+        return false;
+    }
+    if (pending_head == pending.size()) {
+        pending.clear();
+        pending_head = 0;
+        plan_next();
+    }
+    render(pending[pending_head++], out);
+    rows++;
+    return true;
+}
+
+void MboFeedGenerator::plan_next() {
+    ts_event += static_cast<uint64_t>(gap_ns(rng)) + 1;
+    Instrument& instrument = pick_instrument();
+    update_mid(instrument);
+
+    rows_since_reset++;
+    if (profile.reset_every > 0 && rows_since_reset >= profile.reset_every) {
+        rows_since_reset = 0;
+        plan_reset(instrument);
+        return;
+    }
+
+    // Keep each book near its target size; otherwise follow the profile's mix
+    size_t resting = instrument.orders.size();
+    if (resting < target_orders / 2) {
+        plan_add(instrument);
+        return;
+    }
+    if (resting > target_orders * 2) {
+        plan_cancel(instrument);
+        return;
+    }
+
+    double choice = unit(rng);
+    if (choice < profile.trade_ratio) {
+        if (!plan_trade(instrument)) plan_add(instrument);
+    } else if ((choice -= profile.trade_ratio) < profile.lone_trade_ratio) {
+        plan_lone_trade(instrument);
+    } else if ((choice -= profile.lone_trade_ratio) < profile.cancel_ratio) {
+        plan_cancel(instrument);
+    } else if ((choice -= profile.cancel_ratio) < profile.modify_ratio) {
+        plan_modify(instrument);
+    } else {
+        plan_add(instrument);
+    }
+}
+
+MboFeedGenerator::Instrument& MboFeedGenerator::pick_instrument() {
+    double choice = unit(rng);
+    size_t index = static_cast<size_t>(
+        std::lower_bound(instrument_weights.begin(), instrument_weights.end(), choice) - instrument_weights.begin());
+    return instruments[std::min(index, instruments.size() - 1)];
+}
+
+int64_t MboFeedGenerator::quote_price(const Instrument& instrument, char side) {
+    // Measured from the opposite touch (the mid on an empty side), so a new
+    // quote can join or improve the best price but never cross the book
+    int64_t distance = std::min<int64_t>(touch_distance(rng), static_cast<int64_t>(profile.depth) - 1);
+    if (side == 'B') {
+        int64_t best_ask = instrument.asks.empty() ? instrument.mid : instrument.asks.begin()->first;
+        return best_ask - 1 - distance;
+    }
+    int64_t best_bid = instrument.bids.empty() ? instrument.mid : instrument.bids.rbegin()->first;
+    return best_bid + 1 + distance;
+}
+
+uint32_t MboFeedGenerator::order_size() {
+    // Mostly round lots, with odd lots and the occasional large order
+    static constexpr uint32_t SIZES[] = {100, 100, 100, 100, 200, 200, 300, 500, 1, 10, 25, 50, 1000, 100, 200, 100};
+    return SIZES[rng() % (sizeof(SIZES) / sizeof(SIZES[0]))];
+}
+
+void MboFeedGenerator::plan_add(Instrument& instrument) {
+    char side = (rng() & 1) ? 'B' : 'A';
+    Resting order{next_order_id++, quote_price(instrument, side), order_size(), side};
+    insert_order(instrument, order);
+    pending.push_back(PendingRow{&instrument, 'A', side, order.price, order.size, order.order_id, 130});
+}
+
+void MboFeedGenerator::plan_cancel(Instrument& instrument) {
+    if (instrument.orders.empty()) {
+        plan_add(instrument);
+        return;
+    }
+    size_t index = rng() % instrument.orders.size();
+    const Resting& order = instrument.orders[index];
+    pending.push_back(PendingRow{&instrument, 'C', order.side, order.price, order.size, order.order_id, 130});
+    remove_order(instrument, index);
+}
+
+void MboFeedGenerator::plan_modify(Instrument& instrument) {
+    if (instrument.orders.empty()) {
+        plan_add(instrument);
+        return;
+    }
+    Resting& order = instrument.orders[rng() % instrument.orders.size()];
+    if (rng() & 1) {
+        order.size = order_size();
+    } else {
+        // A new price loses priority: the order joins the back of its level
+        unlink_order(instrument, order);
+        order.price = quote_price(instrument, order.side);
+        link_order(instrument, order);
+    }
+    pending.push_back(PendingRow{&instrument, 'M', order.side, order.price, order.size, order.order_id, 130});
+}
+
+bool MboFeedGenerator::plan_trade(Instrument& instrument) {
+    // The aggressor takes the oldest order at the best price of one side;
+    // the further the mid has wandered, the likelier it is pushed back
+    double hit_bid = 0.5 + static_cast<double>(instrument.mid - instrument.anchor) * REVERSION_PER_TICK;
+    char resting_side = unit(rng) < std::min(std::max(hit_bid, 0.1), 0.9) ? 'B' : 'A';
+    const Levels& levels = resting_side == 'B' ? instrument.bids : instrument.asks;
+    if (levels.empty()) {
+        return false;
+    }
+    const std::vector<uint64_t>& touch = resting_side == 'B' ? levels.rbegin()->second : levels.begin()->second;
+    size_t index = instrument.index_of[touch.front()];
+
+    Resting& order = instrument.orders[index];
+    uint32_t quantity = 1 + static_cast<uint32_t>(rng() % order.size);
+    char aggressor = resting_side == 'B' ? 'A' : 'B';
+    pending.push_back(PendingRow{&instrument, 'T', aggressor, order.price, quantity, 0, 130});
+    pending.push_back(PendingRow{&instrument, 'F', order.side, order.price, quantity, order.order_id, 130});
+    pending.push_back(PendingRow{&instrument, 'C', order.side, order.price, quantity, order.order_id, 130});
+    order.size -= quantity;
+    if (order.size == 0) {
+        remove_order(instrument, index);
+    }
+    return true;
+}
+
+void MboFeedGenerator::plan_lone_trade(Instrument& instrument) {
+    // Prints at the mid, e.g. a hidden or off-book execution
+    pending.push_back(PendingRow{&instrument, 'T', 'N', instrument.mid, order_size(), 0, 130});
+}
+
+void MboFeedGenerator::plan_reset(Instrument& instrument) {
+    instrument.orders.clear();
+    instrument.index_of.clear();
+    instrument.bids.clear();
+    instrument.asks.clear();
+    pending.push_back(PendingRow{&instrument, 'R', 'N', NO_PRICE, 0, 0, 8});
+}
+
+void MboFeedGenerator::insert_order(Instrument& instrument, const Resting& order) {
+    instrument.index_of[order.order_id] = instrument.orders.size();
+    instrument.orders.push_back(order);
+    link_order(instrument, order);
+}
+
+void MboFeedGenerator::remove_order(Instrument& instrument, size_t index) {
+    unlink_order(instrument, instrument.orders[index]);
+    instrument.index_of.erase(instrument.orders[index].order_id);
+    if (index + 1 != instrument.orders.size()) {
+        instrument.orders[index] = instrument.orders.back();
+        instrument.index_of[instrument.orders[index].order_id] = index;
+    }
+    instrument.orders.pop_back();
+}
+
+void MboFeedGenerator::link_order(Instrument& instrument, const Resting& order) {
+    Levels& levels = order.side == 'B' ? instrument.bids : instrument.asks;
+    levels[order.price].push_back(order.order_id);
+}
+
+void MboFeedGenerator::unlink_order(Instrument& instrument, const Resting& order) {
+    Levels& levels = order.side == 'B' ? instrument.bids : instrument.asks;
+    auto level = levels.find(order.price);
+    std::vector<uint64_t>& ids = level->second;
+    ids.erase(std::find(ids.begin(), ids.end(), order.order_id));
+    if (ids.empty()) {
+        levels.erase(level);
+    }
+}
+
+void MboFeedGenerator::update_mid(Instrument& instrument) {
+    // With one side empty the last mid stands, which keeps new quotes near it
+    if (!instrument.bids.empty() && !instrument.asks.empty()) {
+        int64_t sum = instrument.bids.rbegin()->first + instrument.asks.begin()->first;
+        instrument.mid = sum / 2;
+    }
+}
+
+void MboFeedGenerator::render(const PendingRow& row, std::string& out) {
+    char ts_recv_text[TIMESTAMP_TEXT_MAX];
+    char ts_event_text[TIMESTAMP_TEXT_MAX];
+    uint64_t delta = 160000 + (sequence * 7919) % 10000;   // Matching-engine to capture latency
+    size_t recv_length = format_timestamp(ts_event + delta, ts_recv_text);
+    size_t event_length = format_timestamp(ts_event, ts_event_text);
+
+    out.append(ts_recv_text, recv_length);
+    out.push_back(',');
+    out.append(ts_event_text, event_length);
+    out.append(",160,");
+    append_uint(out, PUBLISHER_ID);
+    out.push_back(',');
+    append_uint(out, row.instrument->instrument_id);
+    out.push_back(',');
+    out.push_back(row.action);
+    out.push_back(',');
+    out.push_back(row.side);
+    out.push_back(',');
+    if (row.price != NO_PRICE) {
+        append_price(out, row.price * TICK);
+    }
+    out.push_back(',');
+    append_uint(out, row.size);
+    out.append(",0,");
+    append_uint(out, row.order_id);
+    out.push_back(',');
+    append_uint(out, row.flags);
+    out.push_back(',');
+    append_uint(out, row.action == 'R' ? 0 : delta);
+    out.push_back(',');
+    append_uint(out, row.action == 'R' ? 0 : sequence++);
+    out.push_back(',');
+    out.append(row.instrument->symbol);
+    out.push_back('\n');
+}
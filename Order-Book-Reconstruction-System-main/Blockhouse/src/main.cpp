@@ -1,154 +1,333 @@
 #include "../include/orderbook.h"
+#include "../include/dbn_reader.h"
+#include "../include/mbo_reader.h"
+#include "../include/mbp_sinks.h"
+#include "../include/metrics.h"
+#include "../include/replay.h"
+#include "../include/simd_scan.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <chrono>
-#include <vector>
-#include <sstream>
+#include <memory>
+#include <cstdlib>
+
+// Events between checkpoints when --checkpoint is given without --checkpoint-every
+static constexpr uint64_t DEFAULT_CHECKPOINT_EVERY = 1000000;
+
+// Pick the level store and thread layout, then replay into sink. Returns
+// false if checkpointing failed.
+template <typename Book, typename Reader, typename Sink>
+static bool run_with(Reader& reader, Sink& sink, const ReplayOptions& options, size_t threads) {
+    if (threads > 1) {
+        reconstruct_parallel<Book>(reader, sink, options, threads);
+        return true;
+    }
+    return reconstruct<Book>(reader, sink, options);
+}
+
+template <typename Reader, typename Sink>
+static bool run(Reader& reader, Sink& sink, const std::string& levels, const ReplayOptions& options, size_t threads) {
+    // --depth=1 gets the books specialized for the top of book
+    bool bbo = (options.book.output_levels == 1);
+    if (levels == "map") {
+        return bbo ? run_with<MapBboOrderBook>(reader, sink, options, threads)
+                   : run_with<MapOrderBook>(reader, sink, options, threads);
+    }
+    return bbo ? run_with<BboOrderBook>(reader, sink, options, threads)
+               : run_with<OrderBook>(reader, sink, options, threads);
+}
+
+// Settings a resumed replay from Reader must find in the checkpoint
+template <typename Reader>
+static CheckpointHeader resume_settings(const std::string& format, const ReplayOptions& options) {
+    return (format == "binary") ? checkpoint_settings<Reader, BinarySink>(options)
+                                : checkpoint_settings<Reader, CsvSink>(options);
+}
 
 int main(int argc, char* argv[]) {
     // Performance optimization
     std::ios_base::sync_with_stdio(false);
     std::cin.tie(nullptr);
     
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_mbo_file>" << std::endl;
-        return 1;
-    }
+    std::string input_filename;
+    std::string output_filename;
+    bool use_mmap = false;
+    bool direct_io = false;
+    std::string levels = "ladder";
+    std::string format = "csv";
+    size_t threads = 1;
+    std::string metrics_filename;
+    uint64_t metrics_interval_ms = 0;
+    bool resume = false;
+    ReplayOptions options;
+    std::string publish_path;
+    size_t publish_slots = ShmBookPublisher::DEFAULT_SLOTS;
+    CsvSink csv_sink;
+    BinarySink binary_sink;
+    ShmSink shm_sink;
+    std::string index_path;
+    uint64_t index_every = ReplayIndexWriter::DEFAULT_INDEX_EVERY;
+    uint64_t keyframe_every = ReplayIndexWriter::DEFAULT_KEYFRAME_EVERY;
+    ReplayIndexWriter index;
     
-    std::string input_filename = argv[1];
-    std::string output_filename = "output.csv";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mmap") {
+            use_mmap = true;
+        } else if (arg == "--direct-io") {
+            direct_io = true;
+        } else if (arg == "--levels=ladder" || arg == "--levels=map") {
+            levels = arg.substr(9);
+        } else if (arg == "--format=csv" || arg == "--format=binary") {
+            format = arg.substr(9);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = std::strtoul(arg.c_str() + 10, nullptr, 10);
+            if (threads == 0) {
+                std::cerr << "Error: --threads needs a positive count" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--depth=", 0) == 0) {
+            options.book.output_levels = std::strtoul(arg.c_str() + 8, nullptr, 10);
+            if (options.book.output_levels < 1 || options.book.output_levels > MBP_BINARY_LEVELS) {
+                std::cerr << "Error: --depth must be between 1 and " << MBP_BINARY_LEVELS << std::endl;
+                return 1;
+            }
+        } else if (arg == "--changes-only") {
+            options.book.changes_only = true;
+        } else if (arg == "--l3") {
+            options.book.track_queues = true;
+        } else if (arg.rfind("--tfc-window=", 0) == 0) {
+            options.tfc_window = std::strtoul(arg.c_str() + 13, nullptr, 10);
+            if (options.tfc_window < TradeSequencer::MIN_WINDOW) {
+                std::cerr << "Error: --tfc-window must be at least " << TradeSequencer::MIN_WINDOW << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--expected-orders=", 0) == 0) {
+            options.book.expected_orders = std::strtoull(arg.c_str() + 18, nullptr, 10);
+        } else if (arg.rfind("--metrics=", 0) == 0 && arg.size() > 10) {
+            metrics_filename = arg.substr(10);
+        } else if (arg.rfind("--metrics-interval=", 0) == 0) {
+            metrics_interval_ms = std::strtoull(arg.c_str() + 19, nullptr, 10);
+        } else if (arg.rfind("--checkpoint=", 0) == 0 && arg.size() > 13) {
+            options.checkpoint_path = arg.substr(13);
+        } else if (arg.rfind("--checkpoint-every=", 0) == 0) {
+            options.checkpoint_every = std::strtoull(arg.c_str() + 19, nullptr, 10);
+            if (options.checkpoint_every == 0) {
+                std::cerr << "Error: --checkpoint-every needs a positive event count" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--index=", 0) == 0 && arg.size() > 8) {
+            index_path = arg.substr(8);
+        } else if (arg.rfind("--index-every=", 0) == 0) {
+            index_every = std::strtoull(arg.c_str() + 14, nullptr, 10);
+            if (index_every == 0) {
+                std::cerr << "Error: --index-every needs a positive event count" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--keyframe-every=", 0) == 0) {
+            keyframe_every = std::strtoull(arg.c_str() + 17, nullptr, 10);
+            if (keyframe_every == 0) {
+                std::cerr << "Error: --keyframe-every needs a positive entry count" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--resume") {
+            resume = true;
+        } else if (arg.rfind("--publish=", 0) == 0 && arg.size() > 10) {
+            publish_path = arg.substr(10);
+        } else if (arg.rfind("--publish-slots=", 0) == 0) {
+            publish_slots = std::strtoull(arg.c_str() + 16, nullptr, 10);
+            if (publish_slots == 0 || publish_slots > (size_t(1) << 24)) {
+                std::cerr << "Error: --publish-slots must be between 1 and " << (size_t(1) << 24) << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--output=", 0) == 0 && arg.size() > 9) {
+            output_filename = arg.substr(9);
+        } else if (arg.rfind("--scan=", 0) == 0) {
+            std::string isa = arg.substr(7);
+            if (!select_scan_kernels(isa)) {
+                std::cerr << "Error: Scan kernels '" << isa << "' not available on this CPU" << std::endl;
+                return 1;
+            }
+        } else if (input_filename.empty() && arg.rfind("--", 0) != 0) {
+            input_filename = arg;
+        } else {
+            input_filename.clear();
+            break;
+        }
+    }
     
-    // Open input file
-    std::ifstream input_file(input_filename);
-    if (!input_file.is_open()) {
-        std::cerr << "Error: Cannot open input file " << input_filename << std::endl;
+    if (input_filename.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--mmap] [--scan=avx2|sse2|scalar] [--levels=ladder|map] [--format=csv|binary] [--output=<file>] [--direct-io] [--threads=N] [--depth=N] [--changes-only] [--expected-orders=N] [--l3] [--tfc-window=N] [--metrics=<file>] [--metrics-interval=MS] [--checkpoint=<file> [--checkpoint-every=N] [--resume]] [--index=<file> [--index-every=N] [--keyframe-every=N]] [--publish=<shm file> [--publish-slots=N]] <input_mbo_file (CSV or DBN)>" << std::endl;
         return 1;
     }
-    
-    // Open output file
-    std::ofstream output_file(output_filename);
-    if (!output_file.is_open()) {
-        std::cerr << "Error: Cannot create output file " << output_filename << std::endl;
+    if (!publish_path.empty() && (!output_filename.empty() || format != "csv" || direct_io)) {
+        std::cerr << "Error: --publish replaces file output (--output, --format, --direct-io)" << std::endl;
         return 1;
     }
+    if (!publish_path.empty() && !options.checkpoint_path.empty()) {
+        std::cerr << "Error: A published replay cannot be checkpointed (--publish with --checkpoint)" << std::endl;
+        return 1;
+    }
+    if (!publish_path.empty()) {
+        format = "publish";
+        output_filename = publish_path;
+    } else if (output_filename.empty()) {
+        output_filename = (format == "binary") ? "output.mbp" : "output.csv";
+    }
+    if (options.checkpoint_path.empty() && (resume || options.checkpoint_every > 0)) {
+        std::cerr << "Error: --checkpoint-every and --resume need --checkpoint=<file>" << std::endl;
+        return 1;
+    }
+    if (!options.checkpoint_path.empty() && threads > 1) {
+        std::cerr << "Error: Checkpoints need a single-threaded replay (--threads=1)" << std::endl;
+        return 1;
+    }
+    if (!index_path.empty() && (threads > 1 || resume || !publish_path.empty())) {
+        std::cerr << "Error: --index needs a single-threaded replay from the start into an output file"
+                  << " (no --threads, --resume or --publish)" << std::endl;
+        return 1;
+    }
+    if (!options.checkpoint_path.empty() && options.checkpoint_every == 0) {
+        options.checkpoint_every = DEFAULT_CHECKPOINT_EVERY;
+    }
     
-    // Write CSV header
-    output_file << ",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence,";
-    output_file << "bid_px_00,bid_sz_00,bid_ct_00,ask_px_00,ask_sz_00,ask_ct_00,";
-    output_file << "bid_px_01,bid_sz_01,bid_ct_01,ask_px_01,ask_sz_01,ask_ct_01,";
-    output_file << "bid_px_02,bid_sz_02,bid_ct_02,ask_px_02,ask_sz_02,ask_ct_02,";
-    output_file << "bid_px_03,bid_sz_03,bid_ct_03,ask_px_03,ask_sz_03,ask_ct_03,";
-    output_file << "bid_px_04,bid_sz_04,bid_ct_04,ask_px_04,ask_sz_04,ask_ct_04,";
-    output_file << "bid_px_05,bid_sz_05,bid_ct_05,ask_px_05,ask_sz_05,ask_ct_05,";
-    output_file << "bid_px_06,bid_sz_06,bid_ct_06,ask_px_06,ask_sz_06,ask_ct_06,";
-    output_file << "bid_px_07,bid_sz_07,bid_ct_07,ask_px_07,ask_sz_07,ask_ct_07,";
-    output_file << "bid_px_08,bid_sz_08,bid_ct_08,ask_px_08,ask_sz_08,ask_ct_08,";
-    output_file << "bid_px_09,bid_sz_09,bid_ct_09,ask_px_09,ask_sz_09,ask_ct_09,";
-    output_file << "symbol,order_id\n";
-    
-    OrderBook orderbook;
-    std::vector<std::string> all_lines;
-    std::string line;
-    bool first_line = true;
+    // DBN (optionally zstd-compressed) is recognized by its first bytes
+    bool dbn_input = is_dbn_file(input_filename);
     
-    // Read all lines first for look-ahead capability
-    while (std::getline(input_file, line)) {
-        if (first_line) {
-            first_line = false;
-            continue; // Skip header
+    // Resume from the last checkpoint if there is one
+    Checkpoint checkpoint;
+    if (resume) {
+        CheckpointHeader settings = dbn_input ? resume_settings<DbnReader>(format, options)
+                                              : resume_settings<MboReader>(format, options);
+        if (!Checkpoint::exists(options.checkpoint_path)) {
+            std::cout << "No checkpoint at " << options.checkpoint_path << ", starting from the beginning" << std::endl;
+        } else if (!checkpoint.load(options.checkpoint_path)) {
+            std::cerr << "Error: Checkpoint file " << options.checkpoint_path << " is damaged" << std::endl;
+            return 1;
+        } else if (!checkpoint.matches(settings)) {
+            std::cerr << "Error: Checkpoint file " << options.checkpoint_path
+                      << " was written with a different input format or different --format, --depth, --changes-only, --l3"
+                      << " or --tfc-window settings" << std::endl;
+            return 1;
+        } else {
+            options.resume = &checkpoint;
         }
-        all_lines.push_back(line);
     }
-    input_file.close();
-    
-    uint64_t row_index = 0;
-    auto start_time = std::chrono::high_resolution_clock::now();
+    uint64_t input_offset = options.resume ? checkpoint.header.input_offset : 0;
+    uint64_t output_offset = options.resume ? checkpoint.header.output_bytes : 0;
     
-    // Process each line with T->F->C sequence detection
-    for (size_t i = 0; i < all_lines.size(); i++) {
-        std::string current_line = all_lines[i];
-        std::vector<std::string> current_fields;
-        std::stringstream ss(current_line);
-        std::string field;
-        
-        while (std::getline(ss, field, ',')) {
-            current_fields.push_back(field);
+    // Open input file (streamed through a bounded look-ahead window)
+    std::unique_ptr<MboReader> csv_reader;
+    std::unique_ptr<DbnReader> dbn_reader;
+    if (dbn_input) {
+        dbn_reader = std::make_unique<DbnReader>(input_filename, use_mmap, input_offset);
+        if (!dbn_reader->is_open()) {
+            std::cerr << "Error: Cannot read DBN input file " << input_filename << ": " << dbn_reader->error() << std::endl;
+            return 1;
         }
-        
-        if (current_fields.size() < 6) continue;
-        
-        char action = current_fields[5][0];
-        
-        // COMPANY APPROACH: Enhanced T->F->C sequence detection and filtering
-        // Skip Fill actions and redundant Trade actions in T->F->C patterns
-        bool skip_this_action = false;
-        
-        if (action == 'F') {
-            skip_this_action = true; // Always skip Fill actions
+        csv_sink.set_symbols(&dbn_reader->symbols());
+    } else {
+        csv_reader = std::make_unique<MboReader>(input_filename, use_mmap, input_offset);
+        if (!csv_reader->is_open()) {
+            std::cerr << "Error: Cannot open input file " << input_filename << std::endl;
+            return 1;
         }
-        
-        // Advanced T->F->C pattern detection with multiple lookahead
-        if (action == 'T' && i + 1 < all_lines.size()) {
-            // Parse next line
-            std::vector<std::string> next_fields;
-            std::stringstream next_ss(all_lines[i + 1]);
-            std::string next_field;
-            while (std::getline(next_ss, next_field, ',')) {
-                next_fields.push_back(next_field);
-            }
-            
-            // Check if next action is Fill
-            if (next_fields.size() >= 6 && next_fields[5][0] == 'F') {
-                // Found T->F pattern, check for subsequent Cancel
-                for (size_t j = i + 2; j < std::min(i + 5, all_lines.size()); j++) {
-                    std::vector<std::string> future_fields;
-                    std::stringstream future_ss(all_lines[j]);
-                    std::string future_field;
-                    while (std::getline(future_ss, future_field, ',')) {
-                        future_fields.push_back(future_field);
-                    }
-                    
-                    if (future_fields.size() >= 6 && future_fields[5][0] == 'C') {
-                        // Found complete T->F->C sequence, skip the Trade
-                        skip_this_action = true;
-                        break;
-                    } else if (future_fields.size() >= 6 && 
-                              (future_fields[5][0] == 'A' || future_fields[5][0] == 'T')) {
-                        // Found different action, no Cancel follows
-                        break;
-                    }
-                }
-            }
+    }
+    
+    // Open output file, or the shared region live consumers map
+    size_t depth = options.book.output_levels;
+    bool opened;
+    if (format == "publish") {
+        opened = shm_sink.open(publish_path, depth, publish_slots);
+    } else {
+        opened = (format == "binary") ? binary_sink.open(output_filename, depth, direct_io, output_offset)
+                                      : csv_sink.open(output_filename, depth, direct_io, output_offset);
+    }
+    if (!opened && options.resume) {
+        std::cerr << "Error: Cannot resume output file " << output_filename
+                  << " (missing or shorter than the checkpoint)" << std::endl;
+        return 1;
+    }
+    if (!opened) {
+        std::cerr << "Error: Cannot create output file " << output_filename << std::endl;
+        return 1;
+    }
+    if (!index_path.empty()) {
+        if (!index.open(index_path, index_every, keyframe_every)) {
+            std::cerr << "Error: Cannot create index file " << index_path << std::endl;
+            return 1;
         }
-        
-        if (skip_this_action) continue;
-        
-        std::string output_line;
-        orderbook.process_mbo_action(current_line, output_line);
-        
-        // COMPANY REQUIREMENT: Only output when there's a significant change
-        if (!output_line.empty()) {
-            // Update the row index at the beginning of the line
-            size_t first_comma = output_line.find(',');
-            if (first_comma != std::string::npos) {
-                output_line = std::to_string(row_index) + output_line.substr(first_comma);
-            }
-            
-            // Write with consistent line ending, no trailing spaces
-            output_file << output_line << "\n";
-            row_index++;
+        options.index = &index;
+    }
+    if (options.resume) {
+        std::cout << "Resuming at input byte " << input_offset << ", output row " << checkpoint.header.row_index << std::endl;
+    }
+    
+    // Optional per-stage timing report
+    ReplayMetrics metrics;
+    if (!metrics_filename.empty()) {
+        if (!metrics.start(metrics_filename, metrics_interval_ms)) {
+            std::cerr << "Error: Cannot create metrics file " << metrics_filename << std::endl;
+            return 1;
         }
+        metrics.set_output_bytes([&] {
+            if (format == "publish") return shm_sink.bytes_written();
+            return (format == "binary") ? binary_sink.bytes_written() : csv_sink.bytes_written();
+        });
+        options.metrics = &metrics;
     }
     
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    bool checkpointed;
+    if (format == "publish") {
+        checkpointed = dbn_reader ? run(*dbn_reader, shm_sink, levels, options, threads)
+                                  : run(*csv_reader, shm_sink, levels, options, threads);
+    } else if (dbn_reader) {
+        checkpointed = (format == "binary") ? run(*dbn_reader, binary_sink, levels, options, threads)
+                                            : run(*dbn_reader, csv_sink, levels, options, threads);
+    } else {
+        checkpointed = (format == "binary") ? run(*csv_reader, binary_sink, levels, options, threads)
+                                            : run(*csv_reader, csv_sink, levels, options, threads);
+    }
+    
+    // Closing drains the writer thread, so the time includes the last flush
+    bool written = csv_sink.close() && binary_sink.close() && shm_sink.close();
+    
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
     
-    input_file.close();
-    output_file.close();
+    if (!written) {
+        std::cerr << "Error: Failed writing output file " << output_filename << std::endl;
+        return 1;
+    }
+    if (!index.close()) {
+        std::cerr << "Error: Failed writing index file " << index_path << std::endl;
+        return 1;
+    }
+    if (!checkpointed) {
+        std::cerr << "Error: Failed restoring or writing checkpoint file " << options.checkpoint_path << std::endl;
+        return 1;
+    }
+    if (!metrics.stop()) {
+        std::cerr << "Error: Failed writing metrics file " << metrics_filename << std::endl;
+        return 1;
+    }
     
     std::cout << "Processing completed successfully!" << std::endl;
-    std::cout << "Output written to: " << output_filename << std::endl;
+    if (format == "publish") {
+        std::cout << "Published " << shm_sink.published() << " book images to: " << publish_path << std::endl;
+        if (shm_sink.dropped() > 0) {
+            std::cerr << "Warning: " << shm_sink.dropped() << " images of books beyond --publish-slots="
+                      << publish_slots << " were dropped" << std::endl;
+        }
+    } else {
+        std::cout << "Output written to: " << output_filename << std::endl;
+    }
+    if (!index_path.empty()) {
+        std::cout << "Index written to: " << index_path << " (" << index.entries() << " entries)" << std::endl;
+    }
     std::cout << "Processing time: " << duration.count() << " ms" << std::endl;
     
     return 0;
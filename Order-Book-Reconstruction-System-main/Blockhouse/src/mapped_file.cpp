@@ -0,0 +1,63 @@
+#include "../include/mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        // mmap rejects empty ranges; an empty file is simply an empty view
+        ::close(fd);
+        mapped = true;
+        return true;
+    }
+
+    void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference
+    if (address == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+
+    // Input is consumed front to back exactly once
+    madvise(address, length, MADV_SEQUENTIAL);
+    begin = static_cast<const char*>(address);
+    mapped = true;
+    return true;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (begin != nullptr) {
+        munmap(const_cast<char*>(begin), length);
+    }
+#endif
+    begin = nullptr;
+    length = 0;
+    mapped = false;
+}
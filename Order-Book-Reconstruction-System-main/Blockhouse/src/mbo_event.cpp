@@ -0,0 +1,22 @@
+#include "../include/mbo_event.h"
+#include "../include/timestamp.h"
+
+bool to_mbo_event(const MboRecord& record, MboEvent& event) {
+    if (!record.valid || record.size > UINT32_MAX) {
+        return false;
+    }
+    event = MboEvent{};
+    event.order_id = record.order_id;
+    event.price = record.price;
+    event.size = static_cast<uint32_t>(record.size);
+    event.instrument_id = record.instrument_id;
+    event.publisher_id = record.publisher_id;
+    event.action = record.action;
+    event.side = record.side;
+    return parse_timestamp(record.field(MBO_TS_RECV), event.ts_recv) &&
+           parse_timestamp(record.field(MBO_TS_EVENT), event.ts_event) &&
+           decode_number(record.field(MBO_FLAGS), event.flags) &&
+           decode_number(record.field(MBO_CHANNEL_ID), event.channel_id) &&
+           decode_number(record.field(MBO_TS_IN_DELTA), event.ts_in_delta) &&
+           decode_number(record.field(MBO_SEQUENCE), event.sequence);
+}
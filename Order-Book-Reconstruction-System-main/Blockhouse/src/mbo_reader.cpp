@@ -0,0 +1,76 @@
+#include "../include/mbo_reader.h"
+#include "../include/simd_scan.h"
+#include <algorithm>
+
+MboReader::MboReader(const std::string& filename, bool use_mmap, uint64_t start_offset) {
+    if (use_mmap) {
+        if (!mapping.open(filename)) {
+            return;
+        }
+        cursor = mapping.data() + std::min<uint64_t>(start_offset, mapping.size());
+    } else {
+        input.open(filename);
+        if (!input.is_open()) {
+            return;
+        }
+        if (start_offset > 0) {
+            input.seekg(static_cast<std::streamoff>(start_offset));
+        }
+    }
+    bytes = start_offset;
+
+    // Skip header
+    if (start_offset == 0) {
+        std::string header;
+        std::string_view header_view;
+        next_line(header, header_view);
+    }
+    fill();
+}
+
+void MboReader::advance() {
+    if (count == 0) {
+        return;
+    }
+    head = (head + 1) % WINDOW;
+    count--;
+    fill();
+}
+
+bool MboReader::next_line(std::string& storage, std::string_view& line) {
+    if (!mapping.is_open()) {
+        if (!std::getline(input, storage)) {
+            return false;
+        }
+        line = storage;
+        // getline sets eof only when the line ended at end of file, not at a '\n'
+        bytes += storage.size() + (input.eof() ? 0 : 1);
+        return true;
+    }
+
+    // Same framing as std::getline: split on '\n', last line may be unterminated
+    const char* end = mapping.data() + mapping.size();
+    if (cursor >= end) {
+        return false;
+    }
+    const char* newline = scan_byte(cursor, end, '\n');
+    line = std::string_view(cursor, static_cast<size_t>(newline - cursor));
+    bool terminated = (newline < end);
+    cursor = terminated ? newline + 1 : end;
+    bytes += line.size() + (terminated ? 1 : 0);
+    return true;
+}
+
+void MboReader::fill() {
+    // Slots are reused in place so their string capacity is recycled
+    while (count < WINDOW) {
+        Slot& slot = ring[(head + count) % WINDOW];
+        slot.offset = bytes;
+        std::string_view line;
+        if (!next_line(slot.line, line)) {
+            break;
+        }
+        parse_mbo_record(line, slot.record);
+        count++;
+    }
+}
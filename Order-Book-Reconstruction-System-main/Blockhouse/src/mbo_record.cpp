@@ -0,0 +1,79 @@
+#include "../include/mbo_record.h"
+#include "../include/simd_scan.h"
+#include <charconv>
+
+namespace {
+
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+bool parse_mbo_record(std::string_view line, MboRecord& record) {
+    record.data = line.data();
+    record.field_count = 0;
+    record.action = '\0';
+    record.side = '\0';
+    record.price = UNDEF_PRICE;
+    record.size = 0;
+    record.order_id = 0;
+    record.publisher_id = 0;
+    record.instrument_id = 0;
+    record.valid = false;
+
+    // Offsets are 16-bit; no legitimate MBO row comes close
+    if (line.size() > UINT16_MAX) {
+        return false;
+    }
+
+    // Locate every comma in one vectorized pass, then cut fields between
+    // them. Like std::getline, a trailing comma does not open an extra
+    // empty field.
+    const char* base = line.data();
+    const size_t length = line.size();
+    uint32_t commas[MboRecord::MAX_FIELDS];
+    size_t comma_count = scan_all_bytes(base, base + length, ',', commas, MboRecord::MAX_FIELDS);
+
+    size_t pos = 0;
+    for (size_t i = 0; i <= comma_count && record.field_count < MboRecord::MAX_FIELDS; i++) {
+        size_t end = (i < comma_count) ? commas[i] : length;
+        if (i == comma_count && pos >= length) break;
+
+        size_t field_begin = pos;
+        size_t field_end = end;
+        while (field_begin < field_end && is_blank(base[field_begin])) field_begin++;
+        while (field_end > field_begin && is_blank(base[field_end - 1])) field_end--;
+
+        record.field_begin[record.field_count] = static_cast<uint16_t>(field_begin);
+        record.field_end[record.field_count] = static_cast<uint16_t>(field_end);
+        record.field_count++;
+        pos = end + 1;
+    }
+
+    if (record.field_count > MBO_ACTION && !record.field(MBO_ACTION).empty()) {
+        record.action = record.field(MBO_ACTION)[0];
+    }
+    if (record.field_count > MBO_SIDE && !record.field(MBO_SIDE).empty()) {
+        record.side = record.field(MBO_SIDE)[0];
+    }
+
+    if (record.field_count < MBO_FIELD_COUNT) {
+        return false;
+    }
+
+    std::string_view price_text = record.field(MBO_PRICE);
+    record.valid = (price_text.empty() || parse_price(price_text, record.price)) &&
+                   decode_number(record.field(MBO_SIZE), record.size) &&
+                   decode_number(record.field(MBO_ORDER_ID), record.order_id) &&
+                   decode_number(record.field(MBO_PUBLISHER_ID), record.publisher_id) &&
+                   decode_number(record.field(MBO_INSTRUMENT_ID), record.instrument_id);
+    return record.valid;
+}
+
+void copy_mbo_record(const MboRecord& record, std::string& storage, MboRecord& dst) {
+    size_t length = record.field_count > 0 ? record.field_end[record.field_count - 1] : 0;
+    storage.assign(record.data, length);
+    dst = record;
+    dst.data = storage.data();
+}
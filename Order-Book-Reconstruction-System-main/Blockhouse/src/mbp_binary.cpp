@@ -0,0 +1,91 @@
+#include "../include/mbp_binary.h"
+#include "../include/timestamp.h"
+#include <cstring>
+
+namespace {
+
+// Lenient: an empty or unreadable column is 0
+template <typename T>
+T decode_field(std::string_view text) {
+    T value = 0;
+    decode_number(text, value);
+    return value;
+}
+
+} // namespace
+
+void fill_mbp_binary_event(const MboRecord& record, int depth, MbpBinaryRecord& out) {
+    out.ts_recv = 0;
+    out.ts_event = 0;
+    parse_timestamp(record.field(MBO_TS_RECV), out.ts_recv);
+    parse_timestamp(record.field(MBO_TS_EVENT), out.ts_event);
+    out.price = record.price;
+    out.order_id = record.order_id;
+    out.size = record.size;
+    out.instrument_id = record.instrument_id;
+    out.publisher_id = record.publisher_id;
+    out.rtype = 10;  // MBP-10
+    out.action = record.action;
+    out.side = record.side;
+    out.flags = decode_field<uint8_t>(record.field(MBO_FLAGS));
+    out.depth = static_cast<uint8_t>(depth);
+    out.reserved = 0;
+    out.ts_in_delta = decode_field<int32_t>(record.field(MBO_TS_IN_DELTA));
+    out.sequence = decode_field<uint32_t>(record.field(MBO_SEQUENCE));
+    out.padding = 0;
+}
+
+void fill_mbp_binary_event(const MboEvent& event, int depth, MbpBinaryRecord& out) {
+    out.ts_recv = event.ts_recv;
+    out.ts_event = event.ts_event;
+    out.price = event.price;
+    out.order_id = event.order_id;
+    out.size = event.size;
+    out.instrument_id = event.instrument_id;
+    out.publisher_id = event.publisher_id;
+    out.rtype = 10;  // MBP-10
+    out.action = event.action;
+    out.side = event.side;
+    out.flags = event.flags;
+    out.depth = static_cast<uint8_t>(depth);
+    out.reserved = 0;
+    out.ts_in_delta = event.ts_in_delta;
+    out.sequence = event.sequence;
+    out.padding = 0;
+}
+
+bool MbpBinaryWriter::open(const std::string& filename, size_t levels, bool direct, uint64_t keep_bytes) {
+    if (!output.open(filename, direct, keep_bytes)) {
+        return false;
+    }
+    if (keep_bytes > 0) {
+        return true;
+    }
+
+    MbpFileHeader header{};
+    std::memcpy(header.magic, MBP_BINARY_MAGIC, sizeof(header.magic));
+    header.version = MBP_BINARY_VERSION;
+    header.level_count = static_cast<uint16_t>(levels);
+    header.record_size = sizeof(MbpBinaryRecord);
+    header.price_scale = PRICE_SCALE;
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return true;
+}
+
+bool MbpBinaryReader::open(const std::string& filename) {
+    input.open(filename, std::ios::binary);
+    if (!input.is_open()) {
+        return false;
+    }
+    if (!input.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))) {
+        return false;
+    }
+    return std::memcmp(file_header.magic, MBP_BINARY_MAGIC, sizeof(file_header.magic)) == 0 &&
+           file_header.version == MBP_BINARY_VERSION &&
+           file_header.level_count >= 1 && file_header.level_count <= MBP_BINARY_LEVELS &&
+           file_header.record_size == sizeof(MbpBinaryRecord);
+}
+
+bool MbpBinaryReader::next(MbpBinaryRecord& record) {
+    return static_cast<bool>(input.read(reinterpret_cast<char*>(&record), sizeof(record)));
+}
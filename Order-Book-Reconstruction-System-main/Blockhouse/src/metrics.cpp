@@ -0,0 +1,182 @@
+#include "../include/metrics.h"
+#include <cstdio>
+
+namespace {
+
+const char* const STAGE_NAMES[STAGE_COUNT] = {"parse", "book", "render", "write"};
+
+void append_number(std::string& out, const char* key, uint64_t value) {
+    char text[64];
+    int length = std::snprintf(text, sizeof(text), "\"%s\":%llu", key, static_cast<unsigned long long>(value));
+    out.append(text, static_cast<size_t>(length));
+}
+
+void append_rate(std::string& out, const char* key, uint64_t amount, uint64_t elapsed_ns) {
+    double per_second = elapsed_ns > 0 ? static_cast<double>(amount) * 1e9 / static_cast<double>(elapsed_ns) : 0.0;
+    char text[64];
+    int length = std::snprintf(text, sizeof(text), "\"%s\":%.1f", key, per_second);
+    out.append(text, static_cast<size_t>(length));
+}
+
+} // namespace
+
+void HistogramSnapshot::add(const LatencyHistogram& histogram) {
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++) {
+        buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+    count += histogram.samples.load(std::memory_order_relaxed);
+    total += histogram.total.load(std::memory_order_relaxed);
+    uint64_t peak = histogram.peak.load(std::memory_order_relaxed);
+    if (peak > max) max = peak;
+}
+
+uint64_t HistogramSnapshot::percentile(double q) const {
+    // Buckets are read one by one while the writer runs, so their sum may
+    // run slightly ahead of count; rank against what the buckets hold
+    uint64_t held = 0;
+    for (uint64_t n : buckets) held += n;
+    if (held == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(held));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t limit = LatencyHistogram::bucket_limit(i);
+            return limit < max ? limit : max;
+        }
+    }
+    return max;
+}
+
+ReplayMetrics::~ReplayMetrics() {
+    stop();
+}
+
+bool ReplayMetrics::start(const std::string& filename, uint64_t interval_ms) {
+    output.open(filename);
+    if (!output.is_open()) {
+        return false;
+    }
+    start_ns = metrics_now();
+    stopping = false;
+    if (interval_ms > 0) {
+        reporter = std::thread(&ReplayMetrics::run, this, interval_ms);
+    }
+    return true;
+}
+
+StageMetrics& ReplayMetrics::add_thread() {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.push_back(std::make_unique<StageMetrics>());
+    return *threads.back();
+}
+
+bool ReplayMetrics::stop() {
+    if (!output.is_open()) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wake.notify_all();
+    }
+    if (reporter.joinable()) {
+        reporter.join();
+    }
+    output << report(true) << '\n';
+    bool ok = output.good();
+    output.close();
+    return ok;
+}
+
+void ReplayMetrics::run(uint64_t interval_ms) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return stopping; })) {
+        output << report(false) << '\n';
+        output.flush();
+    }
+}
+
+std::string ReplayMetrics::report(bool final) const {
+    uint64_t elapsed = metrics_now() - start_ns;
+
+    // Merge every thread's histograms per stage and action
+    std::vector<HistogramSnapshot> merged(STAGE_COUNT * StageMetrics::ACTION_COUNT);
+    uint64_t input_bytes = 0;
+    uint64_t events = 0;
+    for (const auto& thread : threads) {
+        for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+            for (size_t action = 0; action < StageMetrics::ACTION_COUNT; action++) {
+                merged[stage * StageMetrics::ACTION_COUNT + action].add(thread->histograms[stage][action]);
+            }
+        }
+        input_bytes += thread->input_bytes.load(std::memory_order_relaxed);
+        events += thread->events.load(std::memory_order_relaxed);
+    }
+
+    uint64_t rows = 0;
+    for (size_t action = 0; action < StageMetrics::ACTION_COUNT; action++) {
+        rows += merged[STAGE_WRITE * StageMetrics::ACTION_COUNT + action].count;
+    }
+    uint64_t written = output_bytes ? output_bytes() : 0;
+
+    std::string out = "{";
+    out += final ? "\"final\":true," : "\"final\":false,";
+    append_number(out, "elapsed_ns", elapsed);
+    out += ',';
+    append_number(out, "events", events);
+    out += ',';
+    append_number(out, "rows", rows);
+    out += ',';
+    append_number(out, "input_bytes", input_bytes);
+    out += ',';
+    append_number(out, "output_bytes", written);
+    out += ',';
+    append_rate(out, "events_per_sec", events, elapsed);
+    out += ',';
+    append_rate(out, "rows_per_sec", rows, elapsed);
+    out += ',';
+    append_rate(out, "input_bytes_per_sec", input_bytes, elapsed);
+    out += ',';
+    append_rate(out, "output_bytes_per_sec", written, elapsed);
+    out += ",\"stages\":{";
+    for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+        if (stage > 0) out += ',';
+        out += '"';
+        out += STAGE_NAMES[stage];
+        out += "\":{";
+        bool first = true;
+        for (size_t action = 0; action < StageMetrics::ACTION_COUNT; action++) {
+            const HistogramSnapshot& histogram = merged[stage * StageMetrics::ACTION_COUNT + action];
+            if (histogram.count == 0) continue;
+            if (!first) out += ',';
+            first = false;
+            out += '"';
+            if (action < sizeof(StageMetrics::ACTIONS)) {
+                out += StageMetrics::ACTIONS[action];
+            } else {
+                out += "other";
+            }
+            out += "\":{";
+            append_number(out, "count", histogram.count);
+            out += ',';
+            append_number(out, "mean_ns", histogram.total / histogram.count);
+            out += ',';
+            append_number(out, "p50_ns", histogram.percentile(0.50));
+            out += ',';
+            append_number(out, "p99_ns", histogram.percentile(0.99));
+            out += ',';
+            append_number(out, "p999_ns", histogram.percentile(0.999));
+            out += ',';
+            append_number(out, "max_ns", histogram.max);
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "}}";
+    return out;
+}
@@ -0,0 +1,95 @@
+#include "../include/order_store.h"
+#include <algorithm>
+
+OrderStore::OrderStore(size_t expected_orders) {
+    reserve(expected_orders);
+}
+
+void OrderStore::reserve(size_t expected_orders) {
+    if (expected_orders == 0) {
+        return;
+    }
+
+    size_t slot_count = MIN_SLOTS;
+    while (slot_count < expected_orders * 2) slot_count <<= 1;
+    if (slot_count > slots.size()) {
+        rehash(slot_count);
+    }
+
+    while (chunks.size() * CHUNK_SIZE < expected_orders) {
+        chunks.push_back(std::make_unique<Order[]>(CHUNK_SIZE));
+    }
+    free_nodes.reserve(expected_orders);
+}
+
+bool OrderStore::erase(uint64_t order_id) {
+    if (slots.empty()) {
+        return false;
+    }
+
+    size_t i = home(order_id);
+    for (;; i = (i + 1) & mask) {
+        if (slots[i].epoch != epoch) return false;
+        if (slots[i].key == order_id) break;
+    }
+    free_nodes.push_back(slots[i].node);
+    live--;
+
+    // Backward-shift deletion: pull later entries of the probe run into the
+    // hole unless their home slot lies after it, so no tombstones are needed
+    for (size_t j = (i + 1) & mask; slots[j].epoch == epoch; j = (j + 1) & mask) {
+        size_t distance_from_home = (j - home(slots[j].key)) & mask;
+        size_t distance_from_hole = (j - i) & mask;
+        if (distance_from_home >= distance_from_hole) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    slots[i].epoch = 0;
+    return true;
+}
+
+void OrderStore::clear() {
+    live = 0;
+    pool_used = 0;
+    free_nodes.clear();
+    if (++epoch == 0) {
+        // Epoch wrapped: stale stamps could look live again, so wipe them once
+        for (Slot& slot : slots) slot.epoch = 0;
+        epoch = 1;
+    }
+}
+
+uint32_t OrderStore::allocate_node() {
+    if (!free_nodes.empty()) {
+        uint32_t index = free_nodes.back();
+        free_nodes.pop_back();
+        return index;
+    }
+    if (pool_used == chunks.size() * CHUNK_SIZE) {
+        chunks.push_back(std::make_unique<Order[]>(CHUNK_SIZE));
+    }
+    return pool_used++;
+}
+
+void OrderStore::grow() {
+    rehash(std::max(MIN_SLOTS, slots.size() * 2));
+}
+
+void OrderStore::rehash(size_t slot_count) {
+    std::vector<Slot> old_slots(slot_count, Slot{0, 0, 0});
+    old_slots.swap(slots);
+    uint32_t old_epoch = epoch;
+
+    mask = slot_count - 1;
+    shift = 64;
+    for (size_t n = slot_count; n > 1; n >>= 1) shift--;
+    epoch = 1;
+
+    for (const Slot& slot : old_slots) {
+        if (slot.epoch != old_epoch) continue;
+        size_t i = home(slot.key);
+        while (slots[i].epoch == epoch) i = (i + 1) & mask;
+        slots[i] = Slot{slot.key, slot.node, epoch};
+    }
+}
@@ -1,412 +1,835 @@
 #include "../include/orderbook.h"
-#include <iostream>
-#include <sstream>
-#include <iomanip>
+#include "../include/timestamp.h"
 #include <algorithm>
-#include <vector>
-#include <cmath>
+#include <charconv>
+#include <cstring>
 
-OrderBook::OrderBook() {
-    // Constructor - maps are automatically initialized
+namespace {
+
+template <typename T>
+inline void append_number(std::string& out, T value) {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+inline void append_field(std::string& out, std::string_view field) {
+    out.append(field.data(), field.size());
+}
+
+// Render one level as "px,sz,ct"
+inline uint8_t render_level(char* text, Price price, const PriceLevel& level) {
+    char* p = text + format_price(price, text);
+    *p++ = ',';
+    p = std::to_chars(p, p + 24, level.total_size).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, p + 24, level.order_count).ptr;
+    return static_cast<uint8_t>(p - text);
+}
+
+// Bring the dirty levels among the first visible_levels of image up to date
+// from the best-first level store
+template <size_t Depth, typename LevelStore>
+void refresh_image(SideImage<Depth>& image, const LevelStore& levels, size_t visible_levels) {
+    uint16_t wanted = image.dirty & SideImage<Depth>::top_mask(visible_levels);
+    if (wanted == 0) {
+        return;
+    }
+    
+    size_t rank = 0;
+    auto it = levels.begin();
+    for (; rank < Depth && rank < visible_levels && (wanted >> rank) != 0; ++rank) {
+        bool visible = (it != levels.end());
+        if (wanted & (1u << rank)) {
+            if (visible) {
+                image.length[rank] = render_level(image.text[rank], it->first, it->second);
+            } else {
+                std::memcpy(image.text[rank], ",0,0", 4);  // Empty level: no price, zero size and count
+                image.length[rank] = 4;
+            }
+        }
+        if (visible) ++it;
+    }
+    image.dirty &= static_cast<uint16_t>(~wanted);
+}
+
+// Copy the top levels of one side into the binary record's px/sz/ct columns
+template <typename LevelStore>
+void fill_binary_levels(MbpBinaryRecord& out, const LevelStore& levels, size_t visible_levels,
+                        int64_t MbpBinaryLevel::*px, uint64_t MbpBinaryLevel::*sz, uint32_t MbpBinaryLevel::*ct) {
+    auto it = levels.begin();
+    for (size_t rank = 0; rank < MBP_BINARY_LEVELS; ++rank) {
+        MbpBinaryLevel& level = out.levels[rank];
+        if (rank < visible_levels && it != levels.end()) {
+            level.*px = it->first;
+            level.*sz = it->second.total_size;
+            level.*ct = static_cast<uint32_t>(it->second.order_count);
+            ++it;
+        } else {
+            level.*px = UNDEF_PRICE;
+            level.*sz = 0;
+            level.*ct = 0;
+        }
+    }
+}
+
+// Copy the top levels of one side into a BookUpdate
+template <size_t Depth, typename LevelStore>
+void fill_update_levels(BookLevel* out, const LevelStore& levels, size_t visible_levels) {
+    auto it = levels.begin();
+    for (size_t rank = 0; rank < Depth && rank < visible_levels; ++rank, ++out) {
+        if (it != levels.end()) {
+            *out = BookLevel{it->first, it->second.total_size, it->second.order_count};
+            ++it;
+        } else {
+            *out = BookLevel{UNDEF_PRICE, 0, 0};
+        }
+    }
+}
+
+} // namespace
+
+template <size_t Depth>
+void SideImage<Depth>::level_changed(size_t rank) {
+    if (rank < LEVELS) {
+        dirty |= static_cast<uint16_t>(1u << rank);
+        changed |= static_cast<uint16_t>(1u << rank);
+    }
+}
+
+template <size_t Depth>
+void SideImage<Depth>::level_inserted(size_t rank) {
+    if (rank >= LEVELS) {
+        return;
+    }
+    // Levels at and below rank move down one slot; the last visible one drops off
+    for (size_t i = LEVELS - 1; i > rank; i--) {
+        std::memcpy(text[i], text[i - 1], length[i - 1]);
+        length[i] = length[i - 1];
+    }
+    uint16_t keep = static_cast<uint16_t>((1u << rank) - 1);
+    dirty = static_cast<uint16_t>(((dirty & keep) | ((dirty & ~keep) << 1) | (1u << rank)) & ALL_DIRTY);
+    changed |= static_cast<uint16_t>(ALL_DIRTY & ~keep);
+}
+
+template <size_t Depth>
+void SideImage<Depth>::level_removed(size_t rank) {
+    if (rank >= LEVELS) {
+        return;
+    }
+    // Levels below rank move up one slot; the last slot exposes a hidden level
+    for (size_t i = rank; i + 1 < LEVELS; i++) {
+        std::memcpy(text[i], text[i + 1], length[i + 1]);
+        length[i] = length[i + 1];
+    }
+    uint16_t keep = static_cast<uint16_t>((1u << rank) - 1);
+    dirty = static_cast<uint16_t>((dirty & keep) | ((dirty >> 1) & ~keep) | (1u << (LEVELS - 1)));
+    changed |= static_cast<uint16_t>(ALL_DIRTY & ~keep);
+}
+
+template struct SideImage<1>;
+template struct SideImage<MBP_BINARY_LEVELS>;
+
+template <template <typename> class Levels, size_t Depth>
+BasicOrderBook<Levels, Depth>::BasicOrderBook(const BookOptions& options)
+    : orders(options.expected_orders), track_queues(options.track_queues),
+      output_levels(std::min<size_t>(std::max<size_t>(options.output_levels, 1), Depth)),
+      changes_only(options.changes_only) {
+    // Constructor - level stores initialize themselves
 }
 
-OrderBook::~OrderBook() {
-    // Destructor - maps will be automatically cleaned up
+template <template <typename> class Levels, size_t Depth>
+BasicOrderBook<Levels, Depth>::~BasicOrderBook() {
+    // Destructor - containers clean themselves up
 }
 
-void OrderBook::clear() {
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::clear() {
     bids.clear();
     asks.clear();
     orders.clear();
+    free_rank_trees.clear();
+    for (uint32_t tree = 0; tree < rank_trees.size(); tree++) {
+        free_rank_trees.push_back(tree);
+    }
+    bid_image.invalidate();
+    ask_image.invalidate();
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::save_state(CheckpointWriter& out) const {
+    // Levels best-first as (price, total_size, order_count)
+    auto save_levels = [&out](const auto& levels) {
+        out.put(static_cast<uint64_t>(levels.size()));
+        for (const auto& level : levels) {
+            out.put(level.first);
+            out.put(level.second.total_size);
+            out.put(static_cast<uint64_t>(level.second.order_count));
+        }
+    };
+    save_levels(bids);
+    save_levels(asks);
+    
+    // Orders as (order_id, price, size, side, queued); queued orders come
+    // first, level by level in time priority, so re-queueing them in file
+    // order rebuilds every queue
+    auto save_order = [&out](const Order& order) {
+        out.put(order.order_id);
+        out.put(order.price);
+        out.put(order.size);
+        out.put(order.side);
+        out.put(static_cast<uint8_t>(order.queued));
+    };
+    out.put(static_cast<uint64_t>(orders.size()));
+    auto save_queues = [&](const auto& levels) {
+        for (const auto& level : levels) {
+            for (uint32_t index = level.second.queue_head; index != NO_ORDER; index = orders.at(index).next) {
+                save_order(orders.at(index));
+            }
+        }
+    };
+    save_queues(bids);
+    save_queues(asks);
+    orders.for_each([&](const Order& order) {
+        if (!order.queued) save_order(order);
+    });
+    
+    out.put(bid_image.changed);
+    out.put(ask_image.changed);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::load_state(CheckpointReader& in) {
+    clear();
+    
+    // Levels were saved best-first; inserting them worst-first keeps every
+    // LadderLevels insert at the back
+    std::vector<std::pair<Price, PriceLevel>> saved;
+    auto load_levels = [&](auto& levels) {
+        uint64_t count = 0;
+        if (!in.get(count)) return false;
+        saved.clear();
+        for (uint64_t i = 0; i < count; i++) {
+            std::pair<Price, PriceLevel> level{0, PriceLevel{0, 0, NO_ORDER, NO_ORDER, NO_QUEUE_RANKS}};
+            uint64_t order_count = 0;
+            if (!in.get(level.first) || !in.get(level.second.total_size) || !in.get(order_count)) {
+                return false;
+            }
+            level.second.order_count = static_cast<uint32_t>(order_count);
+            saved.push_back(level);
+        }
+        for (auto it = saved.rbegin(); it != saved.rend(); ++it) {
+            levels[it->first] = it->second;
+        }
+        return true;
+    };
+    if (!load_levels(bids) || !load_levels(asks)) {
+        clear();
+        return false;
+    }
+    
+    uint64_t order_count = 0;
+    bool ok = in.get(order_count);
+    for (uint64_t i = 0; ok && i < order_count; i++) {
+        uint64_t order_id = 0;
+        Price price = 0;
+        uint64_t size = 0;
+        char side = 0;
+        uint8_t queued = 0;
+        ok = in.get(order_id) && in.get(price) && in.get(size) && in.get(side) && in.get(queued);
+        if (!ok) break;
+        
+        uint32_t index = orders.emplace(order_id);
+        Order& order = orders.at(index);
+        order.order_id = order_id;
+        order.price = price;
+        order.size = size;
+        order.side = side;
+        order.prev = NO_ORDER;
+        order.next = NO_ORDER;
+        if (queued != 0) {
+            PriceLevel* level = find_level(side, price);
+            ok = (level != nullptr);
+            if (ok) enqueue_order(*level, index);
+        }
+    }
+    
+    // The rendered text is rebuilt on the next snapshot
+    ok = ok && in.get(bid_image.changed) && in.get(ask_image.changed);
+    if (!ok) {
+        clear();
+    }
+    return ok;
+}
+
+template <template <typename> class Levels, size_t Depth>
+template <typename LevelStore>
+PriceLevel& BasicOrderBook<Levels, Depth>::add_to_level(LevelStore& levels, Image& image, Price price, uint64_t size, const LevelPosition& position) {
+    if (!position.exists) {
+        // New price level
+        PriceLevel& level = (levels[price] = {size, 1});
+        image.level_inserted(position.rank);
+        return level;
+    }
+    // Existing price level - increment both size and count
+    PriceLevel& level = levels[price];
+    level.total_size += size;
+    level.order_count += 1;
+    image.level_changed(position.rank);
+    return level;
+}
+
+template <template <typename> class Levels, size_t Depth>
+template <typename LevelStore>
+bool BasicOrderBook<Levels, Depth>::take_from_level(LevelStore& levels, Image& image, Price price, uint64_t size,
+                                             bool remove_order, uint32_t index, LevelPosition& vacated) {
+    auto it = levels.find(price);
+    if (it == levels.end()) {
+        return false;
+    }
+    
+    // Rank before the change drives the cached top-of-book image
+    bool exists;
+    vacated.rank = levels.rank(price, exists);
+    it->second.total_size -= size;
+    if (remove_order) {
+        // The order leaves the level - decrement count
+        it->second.order_count -= 1;
+        if (orders.at(index).queued) unlink_order(it->second, index);
+    } else if (orders.at(index).queued) {
+        resize_queued_order(it->second, index, orders.at(index).size - size);
+    }
+    vacated.exists = (it->second.total_size != 0);
+    if (!vacated.exists) {
+        release_queue(it->second);
+        levels.erase(it);
+        image.level_removed(vacated.rank);
+    } else {
+        image.level_changed(vacated.rank);
+    }
+    return true;
 }
 
-void OrderBook::add_order(uint64_t order_id, double price, uint64_t size, char side) {
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::add_order(uint64_t order_id, Price price, uint64_t size, char side, const LevelPosition& position) {
     // Store the order
-    orders[order_id] = {price, size, side};
+    uint32_t index = orders.emplace(order_id);
+    Order& order = orders.at(index);
+    if (order.queued) {
+        // Id re-added while resting: the old entry gives up its queue place
+        // (level totals are left as they were)
+        PriceLevel* old_level = find_level(order.side, order.price);
+        if (old_level != nullptr) {
+            unlink_order(*old_level, index);
+        }
+    }
+    order.price = price;
+    order.size = size;
+    order.side = side;
+    order.order_id = order_id;
     
     // Update the appropriate price level
+    PriceLevel* level = nullptr;
     if (side == 'B') {
-        if (bids.find(price) == bids.end()) {
-            // New price level
-            bids[price] = {size, 1};
-        } else {
-            // Existing price level - increment both size and count
-            bids[price].total_size += size;
-            bids[price].order_count += 1;
-        }
+        level = &add_to_level(bids, bid_image, price, size, position);
     } else if (side == 'A') {
-        if (asks.find(price) == asks.end()) {
-            // New price level
-            asks[price] = {size, 1};
-        } else {
-            // Existing price level - increment both size and count
-            asks[price].total_size += size;
-            asks[price].order_count += 1;
-        }
+        level = &add_to_level(asks, ask_image, price, size, position);
+    }
+    
+    // New orders join the back of the queue
+    if (track_queues && level != nullptr) {
+        enqueue_order(*level, index);
     }
 }
 
-void OrderBook::cancel_order(uint64_t order_id, uint64_t size) {
-    auto order_it = orders.find(order_id);
-    if (order_it == orders.end()) {
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::cancel_order(uint64_t order_id, uint64_t size) {
+    uint32_t index = orders.find_index(order_id);
+    if (index == NO_ORDER) {
         return; // Order not found
     }
     
-    Order& order = order_it->second;
-    double price = order.price;
-    char side = order.side;
+    Order& order = orders.at(index);
     uint64_t original_order_size = order.size;
     
     // Determine if this is a complete or partial cancellation
     bool is_complete_cancellation = (size >= original_order_size);
     uint64_t actual_canceled_size = std::min(size, original_order_size);
     
-    // Update the price level
-    if (side == 'B') {
-        auto bid_it = bids.find(price);
-        if (bid_it != bids.end()) {
-            bid_it->second.total_size -= actual_canceled_size;
-            if (is_complete_cancellation) {
-                // Complete order cancellation - decrement count
-                bid_it->second.order_count -= 1;
-            }
-            if (bid_it->second.total_size == 0) {
-                bids.erase(bid_it);
-            }
-        }
-    } else if (side == 'A') {
-        auto ask_it = asks.find(price);
-        if (ask_it != asks.end()) {
-            ask_it->second.total_size -= actual_canceled_size;
-            if (is_complete_cancellation) {
-                // Complete order cancellation - decrement count
-                ask_it->second.order_count -= 1;
-            }
-            if (ask_it->second.total_size == 0) {
-                asks.erase(ask_it);
-            }
-        }
+    // Update the price level. A partial cancel keeps the order's queue
+    // place; a complete one unlinks it.
+    LevelPosition vacated;
+    if (order.side == 'B') {
+        take_from_level(bids, bid_image, order.price, actual_canceled_size, is_complete_cancellation, index, vacated);
+    } else if (order.side == 'A') {
+        take_from_level(asks, ask_image, order.price, actual_canceled_size, is_complete_cancellation, index, vacated);
     }
     
     // Update or remove the order
     if (is_complete_cancellation) {
-        orders.erase(order_it);
+        orders.erase(order_id);
     } else {
         order.size -= actual_canceled_size;
     }
 }
 
-std::string OrderBook::get_mbp_10_snapshot(const std::vector<std::string>& mbo_fields, uint64_t row_index, int depth) const {
-    // Step 1: Declare fixed-size vector for exactly 76 columns
-    std::vector<std::string> output_row(76, "");
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::modify_order(uint64_t order_id, Price price, uint64_t size, char side, const LevelPosition& position) {
+    uint32_t index = orders.find_index(order_id);
+    if (index == NO_ORDER) {
+        // Modify of an order we never saw: it starts resting now
+        add_order(order_id, price, size, side, position);
+        return;
+    }
     
-    // Initialize price fields as empty, size/count fields as "0"
-    for (int i = 14; i < 74; i++) {
-        if ((i - 14) % 6 == 1 || (i - 14) % 6 == 2 || (i - 14) % 6 == 4 || (i - 14) % 6 == 5) {
-            output_row[i] = "0";  // size and count fields
-        }
-        // price fields remain empty string by default
-    }
-    
-    // Step 2: Populate initial MBO data fields (columns 0-13)
-    std::string ts_recv = mbo_fields[0];
-    std::string ts_event = mbo_fields[1];
-    char action = mbo_fields[5][0];
-    char side = mbo_fields[6][0];
-    std::string price_str = mbo_fields[7];
-    std::string size_str = mbo_fields[8];
-    std::string flags = mbo_fields[11];
-    std::string ts_in_delta = mbo_fields[12];
-    std::string sequence = mbo_fields[13];
-    std::string symbol = mbo_fields[14];
-    std::string order_id = mbo_fields[10];
-    
-    // Clean and trim all string fields
-    auto clean_field = [](std::string& field) {
-        size_t start = field.find_first_not_of(" \t\r\n");
-        if (start == std::string::npos) {
-            field = "";
-            return;
-        }
-        size_t end = field.find_last_not_of(" \t\r\n");
-        field = field.substr(start, end - start + 1);
-    };
+    Order& order = orders.at(index);
+    if (size == 0) {
+        cancel_order(order_id, order.size);
+        return;
+    }
     
-    clean_field(ts_event);
-    clean_field(price_str);
-    clean_field(size_str);
-    clean_field(flags);
-    clean_field(ts_in_delta);
-    clean_field(sequence);
-    clean_field(symbol);
-    clean_field(order_id);
-    
-    // Format price to remove trailing zeros
-    if (!price_str.empty() && price_str.find('.') != std::string::npos) {
-        try {
-            double price_val = std::stod(price_str);
-            std::ostringstream price_oss;
-            price_oss << price_val;
-            price_str = price_oss.str();
-            
-            if (price_str.find('.') != std::string::npos) {
-                price_str = price_str.substr(0, price_str.find_last_not_of('0') + 1);
-                if (price_str.back() == '.') {
-                    price_str.pop_back();
-                }
+    if (order.price == price && order.side == side) {
+        // Same level: adjust the aggregate in place. Growing the order costs
+        // its time priority, shrinking it does not.
+        PriceLevel* level = find_level(side, price);
+        if (level != nullptr && size != order.size) {
+            level->total_size = level->total_size - order.size + size;
+            (side == 'B' ? bid_image : ask_image).level_changed(position.rank);
+            if (size > order.size && order.queued) {
+                unlink_order(*level, index);
+                order.size = size;
+                enqueue_order(*level, index);
+            } else if (order.queued) {
+                resize_queued_order(*level, index, size);
             }
-        } catch (...) {
-            // Keep original string if parsing fails
         }
+        order.size = size;
+        return;
     }
     
-    // Populate columns 0-13 with MBO metadata
-    output_row[0] = std::to_string(row_index);
-    output_row[1] = ts_event;
-    output_row[2] = ts_event;
-    output_row[3] = "10";
-    output_row[4] = "2";
-    output_row[5] = "1108";
-    output_row[6] = std::string(1, action);
-    output_row[7] = std::string(1, side);
-    output_row[8] = std::to_string(depth);
-    output_row[9] = price_str;
-    output_row[10] = size_str;
-    output_row[11] = flags;
-    output_row[12] = ts_in_delta;
-    output_row[13] = sequence;
-    
-    // Step 3: Populate the 60 MBP-10 fields (columns 14-73)
-    // Format: bid_px_00,bid_sz_00,bid_ct_00,ask_px_00,ask_sz_00,ask_ct_00 (repeated 10 times)
-    
-    // Step 3a: Iterate through bid levels (up to 10)
-    int bid_level = 0;
-    for (auto it = bids.begin(); it != bids.end() && bid_level < 10; ++it, ++bid_level) {
-        double price = it->first;
-        std::ostringstream price_oss;
-        price_oss << price;
-        std::string formatted_price = price_oss.str();
-        
-        // Remove trailing zeros from price
-        if (formatted_price.find('.') != std::string::npos) {
-            formatted_price = formatted_price.substr(0, formatted_price.find_last_not_of('0') + 1);
-            if (formatted_price.back() == '.') {
-                formatted_price.pop_back();
-            }
-        }
-        
-        // Calculate correct indices: each level has 6 fields (bid_px, bid_sz, bid_ct, ask_px, ask_sz, ask_ct)
-        int base_index = 14 + (bid_level * 6);
-        output_row[base_index + 0] = formatted_price;                           // bid_px_XX
-        output_row[base_index + 1] = std::to_string(it->second.total_size);     // bid_sz_XX
-        output_row[base_index + 2] = std::to_string(it->second.order_count);    // bid_ct_XX
-    }
-    
-    // Step 3b: Iterate through ask levels (up to 10)
-    int ask_level = 0;
-    for (auto it = asks.begin(); it != asks.end() && ask_level < 10; ++it, ++ask_level) {
-        double price = it->first;
-        std::ostringstream price_oss;
-        price_oss << price;
-        std::string formatted_price = price_oss.str();
-        
-        // Remove trailing zeros from price
-        if (formatted_price.find('.') != std::string::npos) {
-            formatted_price = formatted_price.substr(0, formatted_price.find_last_not_of('0') + 1);
-            if (formatted_price.back() == '.') {
-                formatted_price.pop_back();
-            }
-        }
-        
-        // Calculate correct indices: ask fields are offset by 3 from bid fields  
-        int base_index = 14 + (ask_level * 6);
-        output_row[base_index + 3] = formatted_price;                           // ask_px_XX
-        output_row[base_index + 4] = std::to_string(it->second.total_size);     // ask_sz_XX
-        output_row[base_index + 5] = std::to_string(it->second.order_count);    // ask_ct_XX
+    // Price change: leave the old level and join the back of the new one
+    LevelPosition target = position;
+    LevelPosition vacated;
+    bool taken = false;
+    if (order.side == 'B') {
+        taken = take_from_level(bids, bid_image, order.price, order.size, true, index, vacated);
+    } else if (order.side == 'A') {
+        taken = take_from_level(asks, ask_image, order.price, order.size, true, index, vacated);
+    }
+    if (taken && !vacated.exists && order.side == side && vacated.rank < target.rank) {
+        target.rank--;  // A better level on this side just disappeared
     }
     
-    // Step 4: Populate final data fields (columns 74-75)
-    output_row[74] = symbol;     // symbol
-    output_row[75] = order_id;   // order_id
+    order.price = price;
+    order.size = size;
+    order.side = side;
     
-    // Step 5: Join all 76 elements with commas to create output string
-    std::ostringstream result;
-    for (int i = 0; i < 76; i++) {
-        result << output_row[i];
-        if (i < 75) result << ",";  // Add comma except after the last field
+    PriceLevel* level = nullptr;
+    if (side == 'B') {
+        level = &add_to_level(bids, bid_image, price, size, target);
+    } else if (side == 'A') {
+        level = &add_to_level(asks, ask_image, price, size, target);
+    }
+    if (track_queues && level != nullptr) {
+        enqueue_order(*level, index);
     }
-    
-    return result.str();
 }
 
-void OrderBook::process_tfc_sequence(const std::string& t_line, const std::string& f_line, const std::string& c_line, std::string& output_line) {
-    // Parse the C action to get the actual order book impact
-    std::vector<std::string> c_fields;
-    std::stringstream c_ss(c_line);
-    std::string field;
-    
-    while (std::getline(c_ss, field, ',')) {
-        c_fields.push_back(field);
+template <template <typename> class Levels, size_t Depth>
+PriceLevel* BasicOrderBook<Levels, Depth>::find_level(char side, Price price) {
+    if (side == 'B') {
+        auto it = bids.find(price);
+        return it == bids.end() ? nullptr : &it->second;
     }
-    
-    if (c_fields.size() < 15) {
-        output_line = "";
-        return;
+    if (side == 'A') {
+        auto it = asks.find(price);
+        return it == asks.end() ? nullptr : &it->second;
     }
-    
-    // Parse T action for output formatting
-    std::vector<std::string> t_fields;
-    std::stringstream t_ss(t_line);
-    
-    while (std::getline(t_ss, field, ',')) {
-        t_fields.push_back(field);
+    return nullptr;
+}
+
+template <template <typename> class Levels, size_t Depth>
+const PriceLevel* BasicOrderBook<Levels, Depth>::find_level(char side, Price price) const {
+    return const_cast<BasicOrderBook*>(this)->find_level(side, price);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::enqueue_order(PriceLevel& level, uint32_t index) {
+    if (level.queue_ranks == NO_QUEUE_RANKS) {
+        // Reuse a released tree if there is one; out of ranks forces a renumber
+        if (free_rank_trees.empty()) {
+            level.queue_ranks = static_cast<uint32_t>(rank_trees.size());
+            rank_trees.emplace_back();
+        } else {
+            level.queue_ranks = free_rank_trees.back();
+            free_rank_trees.pop_back();
+        }
+        rank_trees[level.queue_ranks].next_rank = rank_trees[level.queue_ranks].capacity();
     }
-    
-    if (t_fields.size() < 15) {
-        output_line = "";
-        return;
+    QueueRanks& ranks = rank_trees[level.queue_ranks];
+    if (ranks.next_rank == ranks.capacity()) {
+        renumber_queue(level, ranks);
     }
     
-    // Use C action details for order book modification (this affects the book)
-    char c_side = c_fields[6][0];
-    uint64_t order_id = 0;
-    uint64_t size = 0;
-    
-    try {
-        if (!c_fields[8].empty()) size = std::stoull(c_fields[8]);
-        if (!c_fields[10].empty()) order_id = std::stoull(c_fields[10]);
-    } catch (const std::exception& e) {
-        output_line = "";
-        return;
+    Order& order = orders.at(index);
+    order.rank = ranks.next_rank++;
+    ranks.add(order.rank, order.size, 1);
+    order.prev = level.queue_tail;
+    order.next = NO_ORDER;
+    order.queued = true;
+    if (level.queue_tail != NO_ORDER) {
+        orders.at(level.queue_tail).next = index;
+    } else {
+        level.queue_head = index;
+    }
+    level.queue_tail = index;
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::unlink_order(PriceLevel& level, uint32_t index) {
+    Order& order = orders.at(index);
+    if (order.prev != NO_ORDER) {
+        orders.at(order.prev).next = order.next;
+    } else {
+        level.queue_head = order.next;
+    }
+    if (order.next != NO_ORDER) {
+        orders.at(order.next).prev = order.prev;
+    } else {
+        level.queue_tail = order.prev;
+    }
+    order.prev = NO_ORDER;
+    order.next = NO_ORDER;
+    order.queued = false;
+    rank_trees[level.queue_ranks].add(order.rank, 0 - order.size, 0 - uint64_t(1));
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::resize_queued_order(const PriceLevel& level, uint32_t index, uint64_t size) {
+    // Size changes in place keep the order's rank; the caller updates order.size
+    const Order& order = orders.at(index);
+    rank_trees[level.queue_ranks].add(order.rank, size - order.size, 0);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::renumber_queue(const PriceLevel& level, QueueRanks& ranks) {
+    // Dense ranks in queue order, with as much room again for new arrivals
+    static constexpr uint32_t MIN_RANKS = 8;
+    uint32_t queued = 0;
+    for (uint32_t index = level.queue_head; index != NO_ORDER; index = orders.at(index).next) {
+        queued++;
+    }
+    ranks.reset(std::max(MIN_RANKS, 2 * (queued + 1)));
+    for (uint32_t index = level.queue_head; index != NO_ORDER; index = orders.at(index).next) {
+        Order& order = orders.at(index);
+        order.rank = ranks.next_rank++;
+        ranks.nodes[order.rank + 1] = QueueRanks::Node{order.size, 1};
+    }
+    ranks.build();
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::release_queue(PriceLevel& level) {
+    // A level can only empty with orders still queued when the feed's sizes
+    // disagree with its orders; drop them from queue tracking with the level
+    for (uint32_t index = level.queue_head; index != NO_ORDER;) {
+        Order& order = orders.at(index);
+        index = order.next;
+        order.prev = NO_ORDER;
+        order.next = NO_ORDER;
+        order.queued = false;
+    }
+    level.queue_head = NO_ORDER;
+    level.queue_tail = NO_ORDER;
+    if (level.queue_ranks != NO_QUEUE_RANKS) {
+        free_rank_trees.push_back(level.queue_ranks);
+        level.queue_ranks = NO_QUEUE_RANKS;
+    }
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::queue_position(uint64_t order_id, QueuePosition& position) const {
+    uint32_t index = orders.find_index(order_id);
+    if (index == NO_ORDER || !orders.at(index).queued) {
+        return false;
     }
     
-    // Skip if side is 'N' (except for clear action and trade actions)
-    if (c_side == 'N') {
-        output_line = "";
-        return;
+    const Order& order = orders.at(index);
+    const PriceLevel* level = find_level(order.side, order.price);
+    if (level == nullptr || level->queue_ranks == NO_QUEUE_RANKS) {
+        return false;
+    }
+    QueueRanks::Node ahead = rank_trees[level->queue_ranks].prefix(order.rank);
+    position = QueuePosition{static_cast<size_t>(ahead.count), ahead.size};
+    return true;
+}
+
+template <template <typename> class Levels, size_t Depth>
+std::string BasicOrderBook<Levels, Depth>::get_mbp_10_snapshot(const MboRecord& record, uint64_t row_index, int depth) const {
+    std::string row;
+    append_mbp_10_snapshot(record, row_index, depth, row);
+    return row;
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::append_mbp_10_snapshot(const MboRecord& record, uint64_t row_index, int depth, std::string& out) const {
+    append_number(out, row_index);
+    append_mbp_10_fields(record, depth, out);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::append_mbp_10_fields(const MboRecord& record, int depth, std::string& out) const {
+    // Step 1: MBO metadata (columns 1-13); fields come pre-trimmed from parse_mbo_record
+    std::string_view ts_event = record.field(MBO_TS_EVENT);
+    out.reserve(out.size() + Layout::ROW_RESERVE);
+    out += ',';
+    append_field(out, ts_event);
+    out += ',';
+    append_field(out, ts_event);
+    out.append(",10,");  // rtype: MBP-10
+    append_number(out, record.publisher_id);
+    out += ',';
+    append_number(out, record.instrument_id);
+    out += ',';
+    out += record.action;
+    out += ',';
+    out += record.side;
+    out += ',';
+    append_number(out, depth);
+    out += ',';
+    if (record.price != UNDEF_PRICE) {
+        // Exact decimal from integer ticks, trailing zeros removed
+        char price_text[PRICE_TEXT_MAX];
+        out.append(price_text, format_price(record.price, price_text));
+    }
+    out += ',';
+    append_field(out, record.field(MBO_SIZE));
+    out += ',';
+    append_field(out, record.field(MBO_FLAGS));
+    out += ',';
+    append_field(out, record.field(MBO_TS_IN_DELTA));
+    out += ',';
+    append_field(out, record.field(MBO_SEQUENCE));
+    out += ',';
+    
+    // Step 2: The 6 fields per visible level (60 for MBP-10)
+    append_level_fields(out);
+    
+    // Step 3: Final data fields (columns 74-75 for MBP-10)
+    append_field(out, record.field(MBO_SYMBOL));
+    out += ',';
+    append_field(out, record.field(MBO_ORDER_ID));
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::append_mbp_10_fields(const MboEvent& event, std::string_view symbol, int depth,
+                                                         std::string& out) const {
+    // Same columns as the text path, formatted from the typed values
+    char ts_event[TIMESTAMP_TEXT_MAX];
+    size_t ts_length = format_timestamp(event.ts_event, ts_event);
+    out.reserve(out.size() + Layout::ROW_RESERVE);
+    out += ',';
+    out.append(ts_event, ts_length);
+    out += ',';
+    out.append(ts_event, ts_length);
+    out.append(",10,");  // rtype: MBP-10
+    append_number(out, event.publisher_id);
+    out += ',';
+    append_number(out, event.instrument_id);
+    out += ',';
+    out += event.action;
+    out += ',';
+    out += event.side;
+    out += ',';
+    append_number(out, depth);
+    out += ',';
+    if (event.price != UNDEF_PRICE) {
+        char price_text[PRICE_TEXT_MAX];
+        out.append(price_text, format_price(event.price, price_text));
     }
+    out += ',';
+    append_number(out, event.size);
+    out += ',';
+    append_number(out, static_cast<unsigned>(event.flags));
+    out += ',';
+    append_number(out, event.ts_in_delta);
+    out += ',';
+    append_number(out, event.sequence);
+    out += ',';
+    append_level_fields(out);
+    append_field(out, symbol);
+    out += ',';
+    append_number(out, event.order_id);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::append_level_fields(std::string& out) const {
+    // Re-render only the visible levels that changed since the last row, then
+    // copy bid_px_00,bid_sz_00,bid_ct_00,ask_px_00,ask_sz_00,ask_ct_00,... from the cache
+    const size_t visible = visible_levels();
+    refresh_image(bid_image, bids, visible);
+    refresh_image(ask_image, asks, visible);
+    for (size_t level = 0; level < Depth && level < visible; level++) {
+        out.append(bid_image.text[level], bid_image.length[level]);
+        out += ',';
+        out.append(ask_image.text[level], ask_image.length[level]);
+        out += ',';
+    }
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::fill_book_update(BookUpdate& out) const {
+    const size_t visible = visible_levels();
+    out.level_count = static_cast<uint8_t>(visible);
+    fill_update_levels<Depth>(out.bids, bids, visible);
+    fill_update_levels<Depth>(out.asks, asks, visible);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::fill_mbp_10_record(const MboRecord& record, int depth, MbpBinaryRecord& out) const {
+    fill_mbp_binary_event(record, depth, out);
+    fill_binary_levels(out, bids, visible_levels(), &MbpBinaryLevel::bid_px, &MbpBinaryLevel::bid_sz, &MbpBinaryLevel::bid_ct);
+    fill_binary_levels(out, asks, visible_levels(), &MbpBinaryLevel::ask_px, &MbpBinaryLevel::ask_sz, &MbpBinaryLevel::ask_ct);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::fill_mbp_10_record(const MboEvent& event, int depth, MbpBinaryRecord& out) const {
+    fill_mbp_binary_event(event, depth, out);
+    fill_binary_levels(out, bids, visible_levels(), &MbpBinaryLevel::bid_px, &MbpBinaryLevel::bid_sz, &MbpBinaryLevel::bid_ct);
+    fill_binary_levels(out, asks, visible_levels(), &MbpBinaryLevel::ask_px, &MbpBinaryLevel::ask_sz, &MbpBinaryLevel::ask_ct);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::process_tfc_sequence(const MboRecord& t_record, const MboRecord& f_record, const MboRecord& c_record, std::string& output_line) {
+    (void)f_record; // The Fill carries no book change of its own
     
-    // Calculate depth BEFORE applying the cancellation
     int depth = 0;
-    double c_price = 0.0;
-    try {
-        if (!c_fields[7].empty()) c_price = std::stod(c_fields[7]);
-    } catch (const std::exception& e) {
+    if (!apply_tfc_sequence(t_record, c_record, depth)) {
         output_line = "";
         return;
     }
     
-    // Find current position of the price level for depth calculation
-    if (c_side == 'B') {
-        int level = 0;
-        for (auto it = bids.begin(); it != bids.end(); ++it, ++level) {
-            if (std::fabs(it->first - c_price) < 1e-9) {
-                depth = level;
-                break;
-            }
-        }
-    } else if (c_side == 'A') {
-        int level = 0;
-        for (auto it = asks.begin(); it != asks.end(); ++it, ++level) {
-            if (std::fabs(it->first - c_price) < 1e-9) {
-                depth = level;
-                break;
-            }
-        }
-    }
-    
-    // Apply the cancellation to the order book
-    cancel_order(order_id, size);
-    
     // Generate output using T action fields but with corrected side and depth
     // According to requirement: "we store the T action on the BID side as that is the side whose change is actually reflected in the book"
     // So we use the C action's side (the side that actually changes) for the output
-    std::vector<std::string> output_fields = t_fields;
-    output_fields[6] = std::string(1, c_side);  // Use the side that actually changed
+    MboRecord output_record = t_record;
+    output_record.side = c_record.side;  // Use the side that actually changed
     
     // Generate MBP-10 snapshot with the T action metadata but correct side
-    output_line = get_mbp_10_snapshot(output_fields, 0, depth);
+    output_line.clear();
+    append_mbp_10_snapshot(output_record, 0, depth, output_line);
 }
 
-bool OrderBook::affects_top10_levels(char action, char side, double price) const {
-    if (action == 'R' || action == 'T') {
-        return true; // Reset and Trade actions always generate output
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_tfc_sequence(const MboRecord& t_record, const MboRecord& c_record, int& depth) {
+    if (!c_record.valid || !t_record.valid) {
+        return false;
     }
     
+    // Use C action details for order book modification (this affects the book)
+    return apply_fused_cancel(c_record.side, c_record.order_id, c_record.price, c_record.size, depth);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_tfc_sequence(const MboEvent& t_event, const MboEvent& c_event, int& depth) {
+    (void)t_event;  // Reported, but has no effect on the book
+    return apply_fused_cancel(c_event.side, c_event.order_id, c_event.price, c_event.size, depth);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_fused_cancel(char c_side, uint64_t order_id, Price price, uint64_t size, int& depth) {
+    // Skip if side is 'N' (except for clear action and trade actions)
+    if (c_side == 'N') {
+        return false;
+    }
+    
+    // Calculate depth BEFORE applying the cancellation, from the current
+    // position of the price level
+    LevelPosition position = locate_level(c_side, price);
+    depth = position.exists ? static_cast<int>(position.rank) : 0;
+    
+    // Apply the cancellation to the order book
+    cancel_order(order_id, size);
+    
+    bool should_generate_output = !changes_only || top_levels_changed();
+    if (should_generate_output) {
+        report_top_levels();
+    }
+    return should_generate_output;
+}
+
+template <template <typename> class Levels, size_t Depth>
+LevelPosition BasicOrderBook<Levels, Depth>::locate_level(char side, Price price) const {
+    LevelPosition position{0, false};
     if (side == 'B') {
-        // For bids, check if price is in top 10 levels
-        int level = 0;
-        for (auto it = bids.begin(); it != bids.end() && level < 10; ++it, ++level) {
-            if (std::fabs(it->first - price) < 1e-9) {
-                return true; // Price found in top 10
-            }
-        }
-        
-        // For Add actions, check if it would be inserted in top 10
-        if (action == 'A') {
-            level = 0;
-            for (auto it = bids.begin(); it != bids.end() && level < 10; ++it, ++level) {
-                if (price > it->first) {
-                    return true; // Would be inserted in top 10
-                }
-            }
-            return level < 10; // Would be added at the end if less than 10 levels
-        }
+        position.rank = bids.rank(price, position.exists);
     } else if (side == 'A') {
-        // For asks, check if price is in top 10 levels
-        int level = 0;
-        for (auto it = asks.begin(); it != asks.end() && level < 10; ++it, ++level) {
-            if (std::fabs(it->first - price) < 1e-9) {
-                return true; // Price found in top 10
-            }
-        }
-        
-        // For Add actions, check if it would be inserted in top 10
-        if (action == 'A') {
-            level = 0;
-            for (auto it = asks.begin(); it != asks.end() && level < 10; ++it, ++level) {
-                if (price < it->first) {
-                    return true; // Would be inserted in top 10
-                }
-            }
-            return level < 10; // Would be added at the end if less than 10 levels
-        }
+        position.rank = asks.rank(price, position.exists);
     }
-    
-    return false; // Doesn't affect top 10 levels
+    return position;
 }
 
-void OrderBook::process_mbo_action(const std::string& line, std::string& output_line) {
-    // Parse CSV line - using simple string parsing for performance
-    std::vector<std::string> fields;
-    std::stringstream ss(line);
-    std::string field;
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::affects_top_levels(char action, char side, Price price) const {
+    if (action == 'R' || action == 'T') {
+        return true; // Reset and Trade actions always generate output
+    }
     
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
+    if (side != 'B' && side != 'A') {
+        return false;
     }
     
-    if (fields.size() < 15) {
-        output_line = "";
-        return;
+    return affects_top_levels(action, locate_level(side, price));
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::affects_top_levels(char action, const LevelPosition& position) const {
+    if (action == 'R' || action == 'T') {
+        return true;
     }
     
-    char action = fields[5][0];
-    char side = fields[6][0];
-    uint64_t order_id = 0;
-    double price = 0.0;
-    uint64_t size = 0;
+    // An existing level in the top Depth, or an Add that would land there
+    if (position.exists || action == 'A') {
+        return position.rank < Depth;
+    }
     
-    // Parse numeric fields
-    try {
-        if (!fields[7].empty()) price = std::stod(fields[7]);
-        if (!fields[8].empty()) size = std::stoull(fields[8]);
-        if (!fields[10].empty()) order_id = std::stoull(fields[10]);
-    } catch (const std::exception& e) {
+    return false; // Doesn't affect the visible levels
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::process_mbo_action(const std::string& line, std::string& output_line) {
+    MboRecord record;
+    parse_mbo_record(line, record);
+    process_mbo_action(record, output_line);
+}
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::process_mbo_action(const MboRecord& record, std::string& output_line) {
+    int depth = 0;
+    if (!apply_mbo_action(record, depth)) {
         output_line = "";
         return;
     }
     
+    output_line.clear();
+    append_mbp_10_snapshot(record, 0, depth, output_line);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_mbo_action(const MboRecord& record, int& depth) {
+    if (!record.valid) {
+        return false;
+    }
+    return apply_action(record.action, record.side, record.order_id, record.price, record.size, depth);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_mbo_action(const MboEvent& event, int& depth) {
+    return apply_action(event.action, event.side, event.order_id, event.price, event.size, depth);
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::apply_action(char action, char side, uint64_t order_id, Price price, uint64_t size, int& depth) {
     // Skip if side is 'N' (except for clear action and trade actions)
     // COMPANY REQUIREMENT: Actually process all actions including side='N'
     // if (side == 'N' && action != 'R' && action != 'T') {
@@ -414,86 +837,20 @@ void OrderBook::process_mbo_action(const std::string& line, std::string& output_
     //     return;
     // }
     
-    // COMPANY REQUIREMENT: Store top-of-book before action
-    double prev_best_bid = (bids.empty()) ? 0.0 : bids.rbegin()->first;
-    double prev_best_ask = (asks.empty()) ? 0.0 : asks.begin()->first;
-    size_t prev_bid_count = bids.size();
-    size_t prev_ask_count = asks.size();
+    // Locate the price level once; every depth rule below reads from it
+    LevelPosition position = locate_level(side, price);
     
     // Calculate depth BEFORE applying the action
-    int depth = 0;
+    depth = 0;
     if (action == 'C' && side != 'N') {
-        // For cancel, find current position of the price level
-        if (side == 'B') {
-            int level = 0;
-            for (auto it = bids.begin(); it != bids.end(); ++it, ++level) {
-                if (std::fabs(it->first - price) < 1e-9) {
-                    depth = level;
-                    break;
-                }
-            }
-        } else if (side == 'A') {
-            int level = 0;
-            for (auto it = asks.begin(); it != asks.end(); ++it, ++level) {
-                if (std::fabs(it->first - price) < 1e-9) {
-                    depth = level;
-                    break;
-                }
-            }
+        // For cancel, the current position of the price level
+        if (position.exists) {
+            depth = static_cast<int>(position.rank);
         }
     } else if (action == 'A' && side != 'N') {
-        // For add, find where it will be inserted
-        if (side == 'B') {
-            // For bids: higher prices come first (descending order)
-            if (bids.empty()) {
-                depth = 0;
-            } else {
-                int level = 0;
-                bool found = false;
-                for (auto it = bids.begin(); it != bids.end() && level < 10; ++it, ++level) {
-                    if (price > it->first) {
-                        // Higher price, insert before this level
-                        depth = level;
-                        found = true;
-                        break;
-                    } else if (std::fabs(it->first - price) < 1e-9) {
-                        // Same price, same level
-                        depth = level;
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    // Lower than all existing prices
-                    depth = level; // Insert at the end of current levels
-                }
-            }
-        } else if (side == 'A') {
-            // For asks: lower prices come first (ascending order)
-            if (asks.empty()) {
-                depth = 0;
-            } else {
-                int level = 0;
-                bool found = false;
-                for (auto it = asks.begin(); it != asks.end() && level < 10; ++it, ++level) {
-                    if (price < it->first) {
-                        // Lower price, insert before this level
-                        depth = level;
-                        found = true;
-                        break;
-                    } else if (std::fabs(it->first - price) < 1e-9) {
-                        // Same price, same level
-                        depth = level;
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    // Higher than all existing prices
-                    depth = level; // Insert at the end of current levels
-                }
-            }
-        }
+        // For add, where it will be inserted; prices below the top 10
+        // levels report the first hidden slot
+        depth = static_cast<int>(std::min<size_t>(position.rank, REPORTED_DEPTH_MAX));
     }
     
     // Process actions according to business rules
@@ -504,7 +861,7 @@ void OrderBook::process_mbo_action(const std::string& line, std::string& output_
             
         case 'A': // Add order
             if (side != 'N') {
-                add_order(order_id, price, size, side);
+                add_order(order_id, price, size, side, position);
             }
             break;
             
@@ -514,27 +871,48 @@ void OrderBook::process_mbo_action(const std::string& line, std::string& output_
             }
             break;
             
+        case 'M': // Modify order in place
+            if (side != 'N') {
+                modify_order(order_id, price, size, side, position);
+                // Depth of the level the order rests at afterwards
+                LevelPosition after = locate_level(side, price);
+                depth = after.exists ? static_cast<int>(std::min<size_t>(after.rank, REPORTED_DEPTH_MAX)) : 0;
+            }
+            break;
+            
         case 'T': // Trade - don't affect orderbook but generate output
             // No orderbook changes, but we still generate output
             break;
             
         case 'F': // Fill - ignore completely, don't generate output
-            output_line = "";
-            return;
+            return false;
             
         default:
-            output_line = "";
-            return;
+            return false;
     }
     
-    // COMPANY REQUIREMENT: Include all actions (no filtering at orderbook level)
-    // Company filtering happens at input processing level (T->F->C sequences)
-    
-    bool should_generate_output = true; // Include all actions by default
-    
+    // COMPANY REQUIREMENT: Include all actions unless only top-of-book
+    // changes are wanted (T->F->C filtering happens before the book)
+    bool should_generate_output = !changes_only || top_levels_changed();
     if (should_generate_output) {
-        output_line = get_mbp_10_snapshot(fields, 0, depth);
-    } else {
-        output_line = ""; // Skip actions not significantly impacting market depth
+        report_top_levels();
     }
+    return should_generate_output;
+}
+
+template <template <typename> class Levels, size_t Depth>
+bool BasicOrderBook<Levels, Depth>::top_levels_changed() const {
+    uint16_t visible = Image::top_mask(visible_levels());
+    return ((bid_image.changed | ask_image.changed) & visible) != 0;
 }
+
+template <template <typename> class Levels, size_t Depth>
+void BasicOrderBook<Levels, Depth>::report_top_levels() {
+    bid_image.changed = 0;
+    ask_image.changed = 0;
+}
+
+template class BasicOrderBook<LadderLevels>;
+template class BasicOrderBook<MapLevels>;
+template class BasicOrderBook<LadderLevels, 1>;
+template class BasicOrderBook<MapLevels, 1>;
@@ -0,0 +1,99 @@
+#include "../include/price.h"
+
+bool parse_price(std::string_view text, Price& price) {
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+        negative = (text[pos] == '-');
+        pos++;
+    }
+
+    // Accumulate as an unsigned magnitude so overflow is caught before the
+    // sign is applied
+    const uint64_t max_whole = static_cast<uint64_t>(INT64_MAX / PRICE_SCALE);
+    uint64_t whole = 0;
+    size_t whole_digits = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+        if (whole > max_whole) {
+            return false;
+        }
+        whole = whole * 10 + static_cast<uint64_t>(text[pos] - '0');
+        whole_digits++;
+        pos++;
+    }
+
+    uint64_t fraction = 0;
+    int fraction_digits = 0;
+    size_t fraction_seen = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        pos++;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            if (fraction_digits < PRICE_DECIMALS) {
+                fraction = fraction * 10 + static_cast<uint64_t>(text[pos] - '0');
+                fraction_digits++;
+            }
+            fraction_seen++;
+            pos++;
+        }
+    }
+
+    if (pos != text.size() || (whole_digits == 0 && fraction_seen == 0) || whole > max_whole) {
+        return false;
+    }
+
+    for (int i = fraction_digits; i < PRICE_DECIMALS; i++) {
+        fraction *= 10;
+    }
+
+    uint64_t magnitude = whole * static_cast<uint64_t>(PRICE_SCALE) + fraction;
+    if (magnitude > static_cast<uint64_t>(INT64_MAX)) {
+        return false;
+    }
+    price = negative ? -static_cast<Price>(magnitude) : static_cast<Price>(magnitude);
+    return true;
+}
+
+size_t format_price(Price price, char* out) {
+    size_t length = 0;
+    uint64_t magnitude;
+    if (price < 0) {
+        out[length++] = '-';
+        magnitude = static_cast<uint64_t>(-(price + 1)) + 1;
+    } else {
+        magnitude = static_cast<uint64_t>(price);
+    }
+
+    uint64_t whole = magnitude / PRICE_SCALE;
+    uint64_t fraction = magnitude % PRICE_SCALE;
+
+    // Integer part, written backwards then reversed in place
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    while (count > 0) {
+        out[length++] = digits[--count];
+    }
+
+    if (fraction != 0) {
+        int decimals = PRICE_DECIMALS;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            decimals--;
+        }
+        out[length++] = '.';
+        for (int i = decimals - 1; i >= 0; i--) {
+            out[length + i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        length += decimals;
+    }
+    return length;
+}
+
+std::string price_to_string(Price price) {
+    char buffer[PRICE_TEXT_MAX];
+    return std::string(buffer, format_price(price, buffer));
+}
@@ -0,0 +1,108 @@
+#include "../include/replay_index.h"
+#include <algorithm>
+#include <cstring>
+
+bool ReplayIndexWriter::open(const std::string& path, uint64_t index_every, uint64_t keyframe_every) {
+    close();
+    index_file.open(path, std::ios::binary | std::ios::trunc);
+    keyframe_file.open(path + REPLAY_KEYFRAME_SUFFIX, std::ios::binary | std::ios::trunc);
+    if (!index_file.is_open() || !keyframe_file.is_open() || index_every == 0 || keyframe_every == 0) {
+        index_file.close();
+        keyframe_file.close();
+        return false;
+    }
+
+    header = ReplayIndexHeader{};
+    std::memcpy(header.magic, REPLAY_INDEX_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_INDEX_VERSION;
+    header.entry_size = sizeof(ReplayIndexEntry);
+    header.index_every = index_every;
+    header.keyframe_every = keyframe_every;
+    index_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    entry_count = 0;
+    keyframe_bytes = 0;
+    last_ts_event = 0;
+    failed = !index_file.good();
+    return !failed;
+}
+
+bool ReplayIndexWriter::add(ReplayIndexEntry entry, Checkpoint* keyframe) {
+    if (failed) {
+        return false;
+    }
+    entry.keyframe_offset = NO_KEYFRAME;
+    if (keyframe != nullptr) {
+        entry.keyframe_offset = keyframe_bytes;
+        if (!keyframe->write(keyframe_file)) {
+            failed = true;
+            return false;
+        }
+        keyframe_bytes += sizeof(CheckpointHeader) + keyframe->payload.size();
+    }
+    if (entry.ts_event < last_ts_event) {
+        header.flags |= REPLAY_INDEX_UNORDERED;
+    }
+    last_ts_event = entry.ts_event;
+    index_file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    entry_count++;
+    failed = !index_file.good();
+    return !failed;
+}
+
+bool ReplayIndexWriter::close() {
+    if (!index_file.is_open()) {
+        return !failed;
+    }
+    // The order flag is only known at the end
+    index_file.seekp(0);
+    index_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    index_file.close();
+    keyframe_file.close();
+    return !failed && !index_file.fail() && !keyframe_file.fail();
+}
+
+bool ReplayIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open() || !in.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))) {
+        return false;
+    }
+    if (std::memcmp(file_header.magic, REPLAY_INDEX_MAGIC, sizeof(file_header.magic)) != 0 ||
+        file_header.version != REPLAY_INDEX_VERSION || file_header.entry_size != sizeof(ReplayIndexEntry)) {
+        return false;
+    }
+    entry_list.clear();
+    ReplayIndexEntry entry;
+    while (in.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+        entry_list.push_back(entry);
+    }
+    keyframe_file.close();
+    keyframe_file.open(path + REPLAY_KEYFRAME_SUFFIX, std::ios::binary);
+    return !entry_list.empty() && entry_list.front().keyframe_offset != NO_KEYFRAME && keyframe_file.is_open();
+}
+
+const ReplayIndexEntry* ReplayIndex::find(uint64_t ts_event) const {
+    auto after = std::upper_bound(entry_list.begin(), entry_list.end(), ts_event,
+                                  [](uint64_t ts, const ReplayIndexEntry& entry) { return ts < entry.ts_event; });
+    return after == entry_list.begin() ? nullptr : &*(after - 1);
+}
+
+const ReplayIndexEntry* ReplayIndex::find_keyframe(uint64_t ts_event) const {
+    const ReplayIndexEntry* entry = find(ts_event);
+    if (entry == nullptr) {
+        return entry_list.empty() ? nullptr : &entry_list.front();
+    }
+    // At most keyframe_every - 1 steps back
+    while (entry->keyframe_offset == NO_KEYFRAME) {
+        entry--;
+    }
+    return entry;
+}
+
+bool ReplayIndex::load_keyframe(const ReplayIndexEntry& entry, Checkpoint& keyframe) {
+    if (entry.keyframe_offset == NO_KEYFRAME) {
+        return false;
+    }
+    keyframe_file.clear();
+    keyframe_file.seekg(static_cast<std::streamoff>(entry.keyframe_offset));
+    return keyframe_file.good() && keyframe.read(keyframe_file);
+}
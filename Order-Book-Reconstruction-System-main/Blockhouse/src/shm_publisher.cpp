@@ -0,0 +1,116 @@
+#include "../include/shm_publisher.h"
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+ShmBookPublisher::~ShmBookPublisher() {
+    close();
+}
+
+bool ShmBookPublisher::open(const std::string& path, size_t levels, size_t slot_capacity) {
+    close();
+#ifndef _WIN32
+    slot_count = 1;
+    while (slot_count < slot_capacity) slot_count <<= 1;
+    length = shm_book_region_size(slot_count);
+
+    // A fresh file, so readers still mapping an old region keep their copy
+    // and never see this one half-initialized
+    ::unlink(path.c_str());
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void* address = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(length)) == 0) {
+        address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd); // The mapping keeps its own reference
+    if (address == MAP_FAILED) {
+        ::unlink(path.c_str());
+        length = 0;
+        return false;
+    }
+
+    // The file starts zeroed: every slot free, state STARTING
+    header = new (address) ShmBookHeader;
+    slots = reinterpret_cast<ShmBookSlot*>(static_cast<char*>(address) + sizeof(ShmBookHeader));
+    header->version = SHM_BOOK_VERSION;
+    header->slot_count = static_cast<uint32_t>(slot_count);
+    header->level_count = static_cast<uint32_t>(levels);
+    header->record_size = sizeof(MbpBinaryRecord);
+    std::memcpy(header->magic, SHM_BOOK_MAGIC, sizeof(header->magic));
+    header->state.store(SHM_BOOK_LIVE, std::memory_order_release);
+    return true;
+#else
+    (void)path;
+    (void)levels;
+    return false;
+#endif
+}
+
+bool ShmBookPublisher::close() {
+    if (header == nullptr) {
+        return true;
+    }
+    header->state.store(SHM_BOOK_FINISHED, std::memory_order_release);
+#ifndef _WIN32
+    munmap(header, length);
+#endif
+    header = nullptr;
+    slots = nullptr;
+    slot_count = 0;
+    length = 0;
+    slot_of.clear();
+    return true;
+}
+
+ShmBookSlot* ShmBookPublisher::claim(uint64_t key) {
+    // Slots are never given back, so a full table stays full: the book is
+    // cached as slotless and its later images are dropped without a scan
+    if (header->books.load(std::memory_order_relaxed) >= slot_count) {
+        slot_of.emplace(key, nullptr);
+        return nullptr;
+    }
+    size_t index = shm_book_home(key, slot_count);
+    for (size_t probes = 0; probes < slot_count; probes++, index = (index + 1) & (slot_count - 1)) {
+        ShmBookSlot& slot = slots[index];
+        if (slot.key.load(std::memory_order_relaxed) == 0) {
+            // Sequence is still 0, so readers that find the key wait for an image
+            slot.key.store(key, std::memory_order_release);
+            header->books.fetch_add(1, std::memory_order_relaxed);
+            slot_of.emplace(key, &slot);
+            return &slot;
+        }
+    }
+    slot_of.emplace(key, nullptr);
+    return nullptr;
+}
+
+void ShmBookPublisher::publish(const MbpBinaryRecord& record) {
+    uint64_t key = shm_book_key(record.publisher_id, record.instrument_id);
+    auto cached = slot_of.find(key);
+    ShmBookSlot* slot = (cached != slot_of.end()) ? cached->second : claim(key);
+    if (slot == nullptr) {
+        header->dropped.store(++dropped_total, std::memory_order_relaxed);
+        return;
+    }
+
+    uint64_t words[SHM_BOOK_WORDS];
+    std::memcpy(words, &record, sizeof(record));
+
+    // Seqlock write: odd sequence, fence so no word store is seen before it,
+    // the words, then an even sequence that releases them
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < SHM_BOOK_WORDS; i++) {
+        slot->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header->publish_count.store(++publish_total, std::memory_order_release);
+}
@@ -0,0 +1,148 @@
+#include "../include/simd_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using ScanByteFn = const char* (*)(const char*, const char*, char);
+using ScanAllFn = size_t (*)(const char*, const char*, char, uint32_t*, size_t);
+
+const char* scan_byte_scalar(const char* begin, const char* end, char c) {
+    while (begin < end && *begin != c) ++begin;
+    return begin;
+}
+
+size_t scan_all_scalar(const char* begin, const char* end, char c, uint32_t* offsets, size_t max) {
+    size_t found = 0;
+    for (const char* p = begin; p < end && found < max; ++p) {
+        if (*p == c) offsets[found++] = static_cast<uint32_t>(p - begin);
+    }
+    return found;
+}
+
+#ifdef SIMD_SCAN_X86
+
+// Append the set bits of a compare mask as offsets; false once max is reached
+inline bool drain_mask(uint32_t mask, uint32_t base, uint32_t* offsets, size_t& found, size_t max) {
+    while (mask) {
+        if (found == max) return false;
+        offsets[found++] = base + static_cast<uint32_t>(__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return true;
+}
+
+__attribute__((target("sse2")))
+const char* scan_byte_sse2(const char* begin, const char* end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = begin;
+    for (; p + 16 <= end; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return scan_byte_scalar(p, end, c);
+}
+
+__attribute__((target("sse2")))
+size_t scan_all_sse2(const char* begin, const char* end, char c, uint32_t* offsets, size_t max) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p = begin;
+    size_t found = 0;
+    for (; p + 16 <= end; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (!drain_mask(mask, static_cast<uint32_t>(p - begin), offsets, found, max)) return found;
+    }
+    size_t tail = scan_all_scalar(p, end, c, offsets + found, max - found);
+    for (size_t i = found; i < found + tail; ++i) offsets[i] += static_cast<uint32_t>(p - begin);
+    return found + tail;
+}
+
+__attribute__((target("avx2")))
+const char* scan_byte_avx2(const char* begin, const char* end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = begin;
+    for (; p + 32 <= end; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return scan_byte_sse2(p, end, c);
+}
+
+__attribute__((target("avx2")))
+size_t scan_all_avx2(const char* begin, const char* end, char c, uint32_t* offsets, size_t max) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p = begin;
+    size_t found = 0;
+    for (; p + 32 <= end; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (!drain_mask(mask, static_cast<uint32_t>(p - begin), offsets, found, max)) return found;
+    }
+    size_t tail = scan_all_sse2(p, end, c, offsets + found, max - found);
+    for (size_t i = found; i < found + tail; ++i) offsets[i] += static_cast<uint32_t>(p - begin);
+    return found + tail;
+}
+
+#endif // SIMD_SCAN_X86
+
+struct ScanKernels {
+    const char* name;
+    ScanByteFn scan_byte;
+    ScanAllFn scan_all;
+};
+
+const ScanKernels SCALAR_KERNELS = {"scalar", scan_byte_scalar, scan_all_scalar};
+#ifdef SIMD_SCAN_X86
+const ScanKernels SSE2_KERNELS = {"sse2", scan_byte_sse2, scan_all_sse2};
+const ScanKernels AVX2_KERNELS = {"avx2", scan_byte_avx2, scan_all_avx2};
+#endif
+
+const ScanKernels* detect_kernels() {
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &AVX2_KERNELS;
+    if (__builtin_cpu_supports("sse2")) return &SSE2_KERNELS;
+#endif
+    return &SCALAR_KERNELS;
+}
+
+const ScanKernels* active_kernels = detect_kernels();
+
+} // namespace
+
+const char* scan_byte(const char* begin, const char* end, char c) {
+    return active_kernels->scan_byte(begin, end, c);
+}
+
+size_t scan_all_bytes(const char* begin, const char* end, char c, uint32_t* offsets, size_t max) {
+    return active_kernels->scan_all(begin, end, c, offsets, max);
+}
+
+bool select_scan_kernels(const std::string& isa) {
+    if (isa == "scalar") {
+        active_kernels = &SCALAR_KERNELS;
+        return true;
+    }
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    if (isa == "sse2" && __builtin_cpu_supports("sse2")) {
+        active_kernels = &SSE2_KERNELS;
+        return true;
+    }
+    if (isa == "avx2" && __builtin_cpu_supports("avx2")) {
+        active_kernels = &AVX2_KERNELS;
+        return true;
+    }
+#endif
+    return false;
+}
+
+const char* active_scan_kernels() {
+    return active_kernels->name;
+}
@@ -0,0 +1,106 @@
+#include "../include/tfc_sequencer.h"
+#include <algorithm>
+
+namespace {
+
+template <typename Record>
+inline bool same_instrument(const Record& a, const Record& b) {
+    return a.publisher_id == b.publisher_id && a.instrument_id == b.instrument_id;
+}
+
+} // namespace
+
+template <typename Record>
+BasicTradeSequencer<Record>::BasicTradeSequencer(size_t window)
+    : window(std::max(window, MIN_WINDOW)), slots(this->window + 1) {
+    pending.reserve(this->window);
+    ready.reserve(this->window + 1);
+}
+
+template <typename Record>
+void BasicTradeSequencer<Record>::push(const Record& record) {
+    ready.clear();
+    ready_head = 0;
+    accept(record);
+}
+
+template <typename Record>
+void BasicTradeSequencer<Record>::finish() {
+    ready.clear();
+    ready_head = 0;
+    release_pending();
+}
+
+template <typename Record>
+bool BasicTradeSequencer<Record>::next(Event& event) {
+    if (ready_head == ready.size()) {
+        return false;
+    }
+    event = ready[ready_head++];
+    return true;
+}
+
+template <typename Record>
+void BasicTradeSequencer<Record>::accept(const Record& record) {
+    if (pending.empty()) {
+        if (record.action == 'T') {
+            pending.push_back(&hold(record));  // May open a sequence
+        } else {
+            emit(&record);
+        }
+        return;
+    }
+
+    const Record& trade = *pending.front();
+    if (pending.size() == 1) {
+        // Held Trade: only an immediate Fill keeps the sequence alive
+        if (record.action == 'F' && same_instrument(record, trade)) {
+            pending.push_back(&hold(record));
+            return;
+        }
+    } else if (record.action == 'C' && same_instrument(record, trade)) {
+        // Sequence complete: rows in between keep their place, then the
+        // fused Trade/Cancel stands in for the Cancel
+        for (size_t i = 2; i < pending.size(); i++) {
+            emit(pending[i]);
+        }
+        emit(pending.front(), &hold(record));
+        pending.clear();
+        return;
+    } else if (record.action != 'A' && record.action != 'T' && pending.size() + 1 < window) {
+        pending.push_back(&hold(record));
+        return;
+    }
+
+    // No sequence: release the held rows, then take record afresh (it may
+    // be a Trade opening the next sequence)
+    release_pending();
+    accept(record);
+}
+
+template <typename Record>
+void BasicTradeSequencer<Record>::release_pending() {
+    for (const Record* held : pending) {
+        emit(held);
+    }
+    pending.clear();
+}
+
+template <typename Record>
+const Record& BasicTradeSequencer<Record>::hold(const Record& record) {
+    // Held rows are the most recent pending.size() slots, and released rows
+    // are only read until the next push, so a window + 1 ring never
+    // overwrites a row that is still referenced
+    Slot& slot = slots[next_slot];
+    next_slot = (next_slot + 1) % slots.size();
+    copy_mbo_record(record, slot.line, slot.record);
+    return slot.record;
+}
+
+template <typename Record>
+void BasicTradeSequencer<Record>::emit(const Record* record, const Record* cancel) {
+    ready.push_back(Event{record, cancel});
+}
+
+template class BasicTradeSequencer<MboRecord>;
+template class BasicTradeSequencer<MboEvent>;
@@ -0,0 +1,128 @@
+#include "../include/timestamp.h"
+#include <charconv>
+
+namespace {
+
+constexpr uint64_t NANOS_PER_SECOND = 1000000000ULL;
+constexpr int64_t SECONDS_PER_DAY = 86400;
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// Fixed-width unsigned decimal at text[pos, pos + width)
+bool read_digits(std::string_view text, size_t pos, size_t width, unsigned& value) {
+    if (pos + width > text.size()) return false;
+    value = 0;
+    for (size_t i = pos; i < pos + width; i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + static_cast<unsigned>(text[i] - '0');
+    }
+    return true;
+}
+
+void write_digits(char* out, unsigned value, size_t width) {
+    for (size_t i = width; i > 0; i--) {
+        out[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+} // namespace
+
+bool parse_timestamp(std::string_view text, uint64_t& nanos) {
+    if (text.empty()) {
+        return false;
+    }
+
+    // Plain integer nanoseconds
+    if (text.find('-') == std::string_view::npos) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), nanos);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    unsigned year, month, day, hour, minute, second;
+    if (!read_digits(text, 0, 4, year) || text.size() < 19 || text[4] != '-' ||
+        !read_digits(text, 5, 2, month) || text[7] != '-' ||
+        !read_digits(text, 8, 2, day) || (text[10] != 'T' && text[10] != ' ') ||
+        !read_digits(text, 11, 2, hour) || text[13] != ':' ||
+        !read_digits(text, 14, 2, minute) || text[16] != ':' ||
+        !read_digits(text, 17, 2, second)) {
+        return false;
+    }
+    if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    size_t pos = 19;
+    uint64_t fraction = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        pos++;
+        size_t digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            if (digits < 9) {
+                fraction = fraction * 10 + static_cast<uint64_t>(text[pos] - '0');
+                digits++;
+            }
+            pos++;
+        }
+        for (; digits < 9; digits++) fraction *= 10;
+    }
+    if (pos < text.size() && text[pos] == 'Z') {
+        pos++;
+    }
+    if (pos != text.size()) {
+        return false;
+    }
+
+    int64_t days = days_from_civil(year, month, day);
+    int64_t seconds = days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    nanos = static_cast<uint64_t>(seconds) * NANOS_PER_SECOND + fraction;
+    return true;
+}
+
+size_t format_timestamp(uint64_t nanos, char* out) {
+    int64_t seconds = static_cast<int64_t>(nanos / NANOS_PER_SECOND);
+    unsigned fraction = static_cast<unsigned>(nanos % NANOS_PER_SECOND);
+    int64_t days = seconds / SECONDS_PER_DAY;
+    unsigned second_of_day = static_cast<unsigned>(seconds % SECONDS_PER_DAY);
+
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(days, year, month, day);
+
+    write_digits(out, static_cast<unsigned>(year), 4);
+    out[4] = '-';
+    write_digits(out + 5, month, 2);
+    out[7] = '-';
+    write_digits(out + 8, day, 2);
+    out[10] = 'T';
+    write_digits(out + 11, second_of_day / 3600, 2);
+    out[13] = ':';
+    write_digits(out + 14, (second_of_day / 60) % 60, 2);
+    out[16] = ':';
+    write_digits(out + 17, second_of_day % 60, 2);
+    out[19] = '.';
+    write_digits(out + 20, fraction, 9);
+    out[29] = 'Z';
+    return 30;
+}
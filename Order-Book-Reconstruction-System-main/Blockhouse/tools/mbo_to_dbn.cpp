@@ -0,0 +1,95 @@
+// Convert an MBO CSV file (data/mbo.csv schema) to DBN, which reconstruction
+// reads without any text parsing (see include/dbn.h)
+#include "../include/async_writer.h"
+#include "../include/dbn.h"
+#include "../include/mbo_event.h"
+#include "../include/mbo_reader.h"
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    std::string input_filename;
+    std::string output_filename;
+    DbnMetadata metadata;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--output=", 0) == 0 && arg.size() > 9) {
+            output_filename = arg.substr(9);
+        } else if (arg.rfind("--dataset=", 0) == 0) {
+            metadata.dataset = arg.substr(10);
+        } else if (input_filename.empty() && arg.rfind("--", 0) != 0) {
+            input_filename = arg;
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok || input_filename.empty() || output_filename.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --output=<file.dbn> [--dataset=NAME] <input_mbo_csv>" << std::endl;
+        return 1;
+    }
+
+    // First pass: the symbology and time range the metadata leads with
+    {
+        MboReader reader(input_filename, true);
+        if (!reader.is_open()) {
+            std::cerr << "Error: Cannot open input file " << input_filename << std::endl;
+            return 1;
+        }
+        metadata.start = UINT64_MAX;
+        metadata.end = 0;
+        MboEvent event;
+        for (; reader.available() > 0; reader.advance()) {
+            const MboRecord& record = reader.peek(0);
+            if (!to_mbo_event(record, event)) continue;
+            metadata.start = std::min(metadata.start, event.ts_recv);
+            metadata.end = std::max(metadata.end, event.ts_recv + 1);
+            std::string_view symbol = record.field(MBO_SYMBOL);
+            if (!symbol.empty()) {
+                metadata.symbols[event.instrument_id] = std::string(symbol);
+            }
+        }
+        if (metadata.start == UINT64_MAX) {
+            metadata.start = 0;
+            metadata.end = UINT64_MAX;
+        }
+    }
+
+    AsyncFileWriter output;
+    if (!output.open(output_filename)) {
+        std::cerr << "Error: Cannot create output file " << output_filename << std::endl;
+        return 1;
+    }
+    std::string block;
+    encode_dbn_metadata(metadata, block);
+    output.write(block.data(), block.size());
+
+    // Second pass: one fixed-width record per valid row
+    MboReader reader(input_filename, true);
+    MboEvent event;
+    DbnMboMsg msg;
+    uint64_t records = 0;
+    uint64_t skipped = 0;
+    for (; reader.available() > 0; reader.advance()) {
+        if (!to_mbo_event(reader.peek(0), event)) {
+            skipped++;
+            continue;
+        }
+        to_dbn_mbo(event, msg);
+        output.write(reinterpret_cast<const char*>(&msg), sizeof(msg));
+        records++;
+    }
+    if (!output.close()) {
+        std::cerr << "Error: Failed writing output file " << output_filename << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << records << " records for " << metadata.symbols.size() << " instruments to "
+              << output_filename << std::endl;
+    if (skipped > 0) {
+        std::cout << "Skipped " << skipped << " rows that are not valid MBO events" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Print a binary MBP file (--format=binary output) as CSV, with as many
+// levels as the file was written with
+#include "../include/mbp_binary.h"
+#include "../include/price.h"
+#include "../include/timestamp.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+static void print_price(int64_t price) {
+    if (price != UNDEF_PRICE) {
+        char text[PRICE_TEXT_MAX];
+        std::fwrite(text, 1, format_price(price, text), stdout);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <output.mbp>" << std::endl;
+        return 1;
+    }
+    
+    MbpBinaryReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Error: " << argv[1] << " is not a version " << MBP_BINARY_VERSION
+                  << " MBP binary file" << std::endl;
+        return 1;
+    }
+    size_t levels = reader.header().level_count;
+    
+    std::printf(",ts_recv,ts_event,rtype,publisher_id,instrument_id,action,side,depth,price,size,flags,ts_in_delta,sequence");
+    for (size_t level = 0; level < levels; level++) {
+        std::printf(",bid_px_%02zu,bid_sz_%02zu,bid_ct_%02zu,ask_px_%02zu,ask_sz_%02zu,ask_ct_%02zu",
+                    level, level, level, level, level, level);
+    }
+    std::printf(",order_id\n");
+    
+    MbpBinaryRecord record;
+    char ts_recv[TIMESTAMP_TEXT_MAX];
+    char ts_event[TIMESTAMP_TEXT_MAX];
+    for (uint64_t row = 0; reader.next(record); row++) {
+        size_t recv_length = format_timestamp(record.ts_recv, ts_recv);
+        size_t event_length = format_timestamp(record.ts_event, ts_event);
+        std::printf("%llu,%.*s,%.*s,%u,%u,%u,%c,%c,%u,",
+                    static_cast<unsigned long long>(row),
+                    static_cast<int>(recv_length), ts_recv,
+                    static_cast<int>(event_length), ts_event,
+                    record.rtype, record.publisher_id, record.instrument_id,
+                    record.action, record.side, record.depth);
+        print_price(record.price);
+        std::printf(",%llu,%u,%d,%u", static_cast<unsigned long long>(record.size), record.flags,
+                    record.ts_in_delta, record.sequence);
+        for (size_t index = 0; index < levels; index++) {
+            const MbpBinaryLevel& level = record.levels[index];
+            std::putchar(',');
+            print_price(level.bid_px);
+            std::printf(",%llu,%u,", static_cast<unsigned long long>(level.bid_sz), level.bid_ct);
+            print_price(level.ask_px);
+            std::printf(",%llu,%u", static_cast<unsigned long long>(level.ask_sz), level.ask_ct);
+        }
+        std::printf(",%llu\n", static_cast<unsigned long long>(record.order_id));
+    }
+    return 0;
+}
@@ -0,0 +1,284 @@
+// Point-in-time book queries against a replay index (see include/replay_index.h):
+// the top levels of each book as of the given ts_event times, found by
+// loading the nearest keyframe and replaying the input from there
+#include "../include/book_manager.h"
+#include "../include/dbn.h"
+#include "../include/dbn_reader.h"
+#include "../include/mbo_reader.h"
+#include "../include/mbp_layout.h"
+#include "../include/orderbook.h"
+#include "../include/replay.h"
+#include "../include/replay_index.h"
+#include "../include/timestamp.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct QueryOptions {
+    std::string input_filename;
+    std::vector<uint64_t> times;   // Sorted
+    long instrument = -1;          // All books when negative
+    long publisher = -1;
+};
+
+struct QueryStats {
+    uint64_t keyframes = 0;        // Keyframes loaded
+    uint64_t events = 0;           // Input events replayed after them
+};
+
+inline bool event_ts(const MboEvent& event, uint64_t& ts) {
+    ts = event.ts_event;
+    return true;
+}
+
+inline bool event_ts(const MboRecord& record, uint64_t& ts) {
+    return parse_timestamp(record.field(MBO_TS_EVENT), ts);
+}
+
+template <typename T>
+void append_number(std::string& out, T value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    out.append(text, static_cast<size_t>(result.ptr - text));
+}
+
+void append_level(std::string& out, const BookLevel& level) {
+    out += ',';
+    if (level.price != UNDEF_PRICE) {
+        char price[PRICE_TEXT_MAX];
+        out.append(price, format_price(level.price, price));
+    }
+    out += ',';
+    append_number(out, level.size);
+    out += ',';
+    append_number(out, level.count);
+}
+
+// One row per selected book: the query time, the book's key and its levels
+// in the column order of the MBP output
+template <typename Book>
+void append_books(const BookManager<Book>& books, uint64_t at, const QueryOptions& query, std::string& out) {
+    struct Found {
+        uint16_t publisher_id;
+        uint32_t instrument_id;
+        const Book* book;
+    };
+    std::vector<Found> found;
+    books.visit_books([&](uint16_t publisher_id, uint32_t instrument_id, const Book& book) {
+        if ((query.publisher < 0 || publisher_id == query.publisher) &&
+            (query.instrument < 0 || instrument_id == query.instrument)) {
+            found.push_back({publisher_id, instrument_id, &book});
+        }
+    });
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+        return a.publisher_id != b.publisher_id ? a.publisher_id < b.publisher_id : a.instrument_id < b.instrument_id;
+    });
+
+    char time_text[TIMESTAMP_TEXT_MAX];
+    size_t time_length = format_timestamp(at, time_text);
+    BookUpdate update{};
+    for (const Found& entry : found) {
+        entry.book->fill_book_update(update);
+        out.append(time_text, time_length);
+        out += ',';
+        append_number(out, entry.publisher_id);
+        out += ',';
+        append_number(out, entry.instrument_id);
+        for (size_t level = 0; level < update.level_count; level++) {
+            append_level(out, update.bids[level]);
+            append_level(out, update.asks[level]);
+        }
+        out += '\n';
+    }
+}
+
+// Apply the input from reader's position up to (not including) the first
+// event later than at. Returns whether the replay can go on for a later
+// time: rows still held back for T->F->C detection are all before the stop
+// and are released as plain events, which leaves the books as the full
+// replay had them (a held Trade or Fill has no book effect) but means a
+// resolving Cancel further on would no longer be fused.
+template <typename Book, typename Reader>
+bool replay_until(Reader& reader, BasicTradeSequencer<typename Reader::Record>& sequencer, BookManager<Book>& books,
+                  uint64_t at, QueryStats& stats) {
+    using Record = typename Reader::Record;
+    Record fused_record;
+    auto apply_released = [&] {
+        BasicSequencedEvent<Record> event;
+        int depth = 0;
+        while (sequencer.next(event)) {
+            apply_sequenced_event(books.book_for(*event.record), event, fused_record, depth);
+        }
+    };
+
+    for (; reader.available() > 0; reader.advance()) {
+        const Record& current = reader.peek(0);
+        if (!replayable(current)) continue;
+        uint64_t ts = 0;
+        if (event_ts(current, ts) && ts > at) break;
+        sequencer.push(current);
+        apply_released();
+        stats.events++;
+    }
+    if (sequencer.idle()) {
+        return true;
+    }
+    sequencer.finish();
+    apply_released();
+    return false;
+}
+
+// Answer query.times in order. Consecutive times share one forward replay
+// unless a later keyframe is closer.
+template <typename Book, typename Reader>
+bool answer(ReplayIndex& index, const CheckpointHeader& settings, const QueryOptions& query, QueryStats& stats) {
+    using Record = typename Reader::Record;
+    BookOptions book_options;
+    book_options.output_levels = settings.output_levels;
+    book_options.changes_only = settings.changes_only != 0;
+    book_options.track_queues = settings.track_queues != 0;
+    BookManager<Book> books(book_options);
+    std::unique_ptr<Reader> reader;
+    std::unique_ptr<BasicTradeSequencer<Record>> sequencer;
+    bool live = false;
+
+    std::string header = "as_of,publisher_id,instrument_id,";
+    append_mbp_level_columns(header, settings.output_levels);
+    header.back() = '\n';
+    std::cout << header;
+
+    std::string rows;
+    for (uint64_t at : query.times) {
+        const ReplayIndexEntry* start = index.find_keyframe(at);
+        if (!live || start->input_offset > reader->position()) {
+            Checkpoint keyframe;
+            if (!index.load_keyframe(*start, keyframe) || !keyframe.matches(settings)) {
+                std::cerr << "Error: Keyframe at input byte " << start->input_offset << " is missing or damaged"
+                          << std::endl;
+                return false;
+            }
+            CheckpointReader in(keyframe.payload.data(), keyframe.payload.size());
+            if (!books.load_state(in) || !in.at_end()) {
+                std::cerr << "Error: Keyframe at input byte " << start->input_offset << " is damaged" << std::endl;
+                return false;
+            }
+            reader = std::make_unique<Reader>(query.input_filename, true, start->input_offset);
+            if (!reader->is_open()) {
+                std::cerr << "Error: Cannot open input file " << query.input_filename << std::endl;
+                return false;
+            }
+            sequencer = std::make_unique<BasicTradeSequencer<Record>>(settings.tfc_window);
+            stats.keyframes++;
+        }
+        live = replay_until(*reader, *sequencer, books, at, stats);
+        append_books(books, at, query, rows);
+        if (rows.size() >= 64 * 1024) {
+            std::cout << rows;
+            rows.clear();
+        }
+    }
+    std::cout << rows;
+    return true;
+}
+
+bool add_time(const std::string& text, std::vector<uint64_t>& times) {
+    uint64_t ts = 0;
+    if (!parse_timestamp(text, ts)) {
+        std::cerr << "Error: '" << text << "' is not a timestamp" << std::endl;
+        return false;
+    }
+    times.push_back(ts);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::ios_base::sync_with_stdio(false);
+
+    QueryOptions query;
+    std::string index_path;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--index=", 0) == 0 && arg.size() > 8) {
+            index_path = arg.substr(8);
+        } else if (arg.rfind("--at=", 0) == 0) {
+            if (!add_time(arg.substr(5), query.times)) return 1;
+        } else if (arg.rfind("--at-file=", 0) == 0) {
+            std::ifstream times(arg.substr(10));
+            if (!times.is_open()) {
+                std::cerr << "Error: Cannot open " << arg.substr(10) << std::endl;
+                return 1;
+            }
+            for (std::string line; std::getline(times, line);) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty() && !add_time(line, query.times)) return 1;
+            }
+        } else if (arg.rfind("--instrument=", 0) == 0) {
+            query.instrument = std::strtol(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.rfind("--publisher=", 0) == 0) {
+            query.publisher = std::strtol(arg.c_str() + 12, nullptr, 10);
+        } else if (query.input_filename.empty() && arg.rfind("--", 0) != 0) {
+            query.input_filename = arg;
+        } else {
+            ok = false;
+        }
+    }
+    if (!ok || index_path.empty() || query.times.empty() || query.input_filename.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --index=<file> --at=<ts_event> [--at=...] [--at-file=<file>]"
+                  << " [--instrument=ID] [--publisher=ID] <input_mbo_file the index was built from>" << std::endl;
+        std::cerr << "Times are ISO-8601 UTC (2025-07-17T08:05:03.5Z) or nanoseconds since the epoch" << std::endl;
+        return 1;
+    }
+    std::sort(query.times.begin(), query.times.end());
+
+    ReplayIndex index;
+    if (!index.load(index_path)) {
+        std::cerr << "Error: Cannot read index file " << index_path << std::endl;
+        return 1;
+    }
+    if (!index.ordered()) {
+        std::cerr << "Warning: The indexed feed is not in ts_event order; answers near out-of-order events may be off"
+                  << std::endl;
+    }
+
+    // The first keyframe (the start of the replay) carries the run's settings
+    Checkpoint first;
+    if (!index.load_keyframe(index.entries().front(), first)) {
+        std::cerr << "Error: Cannot read keyframes of " << index_path << std::endl;
+        return 1;
+    }
+    const CheckpointHeader& settings = first.header;
+    bool dbn_input = is_dbn_file(query.input_filename);
+    if (settings.input_format != (dbn_input ? DbnReader::FORMAT_ID : MboReader::FORMAT_ID)) {
+        std::cerr << "Error: " << index_path << " was built from " << (dbn_input ? "CSV" : "DBN") << " input" << std::endl;
+        return 1;
+    }
+
+    QueryStats stats;
+    bool answered;
+    bool bbo = (settings.output_levels == 1);
+    if (dbn_input) {
+        answered = bbo ? answer<BboOrderBook, DbnReader>(index, settings, query, stats)
+                       : answer<OrderBook, DbnReader>(index, settings, query, stats);
+    } else {
+        answered = bbo ? answer<BboOrderBook, MboReader>(index, settings, query, stats)
+                       : answer<OrderBook, MboReader>(index, settings, query, stats);
+    }
+    std::cout.flush();
+    if (!answered) {
+        return 1;
+    }
+    std::cerr << "Answered " << query.times.size() << " queries from " << stats.keyframes << " keyframes, replaying "
+              << stats.events << " events" << std::endl;
+    return 0;
+}